@@ -0,0 +1,71 @@
+/* 
+ * Example parsing the same document as JSON, CBOR and MessagePack with one handler.
+ *
+ * Note: The binary encodings are 16 and 19 bytes against 29 for the JSON text, and
+ *       decoding them involves no text scanning or number conversion at all.
+ */
+#include "JsonStreamingParser2.h"
+#include "CborStreamingParser.h"
+#include "MsgPackStreamingParser.h"
+#include "JsonHandler.h"
+
+class PrintingHandler: public JsonHandler {
+  public:
+    void startDocument() { }
+    void endDocument() { Serial.println("--"); }
+    void startObject(ElementPath path) { }
+    void endObject(ElementPath path) { }
+    void startArray(ElementPath path) { }
+    void endArray(ElementPath path) { }
+    void whitespace(char c) { }
+
+    void value(ElementPath path, ElementValue value) {
+      char fullPath[200] = "";
+      char valueText[50];
+      path.toString(fullPath);
+      Serial.print(fullPath);
+      Serial.print(": ");
+      Serial.println(value.toString(valueText, sizeof(valueText)));
+    }
+};
+
+// {"temp": 21.5, "ids": [1, 2]}
+const char json[] = "{\"temp\": 21.5, \"ids\": [1, 2]}";
+
+const uint8_t cbor[] = {
+  0xA2,                                   // map(2)
+  0x64, 't', 'e', 'm', 'p', 0xF9, 0x4D, 0x60,   // "temp": 21.5 (half float)
+  0x63, 'i', 'd', 's', 0x82, 0x01, 0x02         // "ids": [1, 2]
+};
+
+const uint8_t msgpack[] = {
+  0x82,                                   // fixmap(2)
+  0xA4, 't', 'e', 'm', 'p', 0xCA, 0x41, 0xAC, 0x00, 0x00,   // "temp": 21.5 (float 32)
+  0xA3, 'i', 'd', 's', 0x92, 0x01, 0x02                     // "ids": [1, 2]
+};
+
+PrintingHandler handler;
+
+JsonStreamingParser jsonParser;
+CborStreamingParser cborParser;
+MsgPackStreamingParser msgpackParser;
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  jsonParser.setHandler(&handler);
+  jsonParser.parse(json, sizeof(json) - 1);
+
+  cborParser.setHandler(&handler);
+  cborParser.parse((const char*) cbor, sizeof(cbor));
+
+  msgpackParser.setHandler(&handler);
+  msgpackParser.parse((const char*) msgpack, sizeof(msgpack));
+  if (msgpackParser.hasParseError()) {
+    Serial.println(msgpackParser.getErrorMessage());
+  }
+}
+
+void loop() {
+}
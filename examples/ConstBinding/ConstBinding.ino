@@ -0,0 +1,49 @@
+/* 
+ * Example of binding constant JSON at compile time: the sensor table below is parsed by
+ * the compiler into a constant array of structs, so nothing is parsed at boot and the
+ * table takes no RAM (on boards where constants stay in flash).
+ *
+ * Note: Needs C++20, e.g. build_flags = -std=gnu++2a and build_unflags = -std=gnu++11
+ *       in PlatformIO. A malformed table, or one that does not match the struct, does
+ *       not compile.
+ */
+#include "JsonConstBinding.h"
+
+#if __cplusplus < 202002L
+#error "This example needs C++20 (-std=gnu++2a)"
+#endif
+
+struct Sensor
+{
+    int     pin;
+    float   gain;
+    float   offset;
+    char    name[12];
+    bool    enabled;
+};
+
+constexpr auto sensors = jsonConstParse<Sensor, 8>(R"([
+    { "pin": 32, "gain": 1.25,  "offset": -0.5, "name": "boiler",  "enabled": true },
+    { "pin": 33, "gain": 0.98,  "offset": 0,    "name": "outside", "enabled": true },
+    { "pin": 34, "gain": 1.0e0, "offset": 2.25, "name": "spare",   "enabled": false }
+  ])",
+  jsonConstBind(&Sensor::pin,     "[].pin"),
+  jsonConstBind(&Sensor::gain,    "[].gain"),
+  jsonConstBind(&Sensor::offset,  "[].offset"),
+  jsonConstBind(&Sensor::name,    "[].name"),
+  jsonConstBind(&Sensor::enabled, "[].enabled"));
+
+static_assert(sensors.size() == 3, "three sensors configured");
+
+void setup() {
+  Serial.begin(115200);
+
+  for (const Sensor& sensor : sensors) {
+    if (sensor.enabled) {
+      Serial.printf("%s on pin %d: value = raw * %.2f + %.2f\n", sensor.name, sensor.pin, sensor.gain, sensor.offset);
+    }
+  }
+}
+
+void loop() {
+}
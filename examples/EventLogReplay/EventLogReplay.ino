@@ -0,0 +1,65 @@
+/* 
+ * Example recording the events of a parsed document into a compact binary log once,
+ * then replaying them into a handler as often as needed without parsing again.
+ *
+ * Note: Logs can just as well be written to a file (JsonSink over a File) and replayed
+ *       from it with replayer.replay(file, &handler), e.g. to cache a forecast across
+ *       reboots.
+ */
+#include "JsonStreamingParser2.h"
+#include "JsonEventLog.h"
+#include "JsonHandler.h"
+
+class PrintingHandler: public JsonHandler {
+  public:
+    void startDocument() { }
+    void endDocument() { }
+    void startObject(ElementPath path) { }
+    void endObject(ElementPath path) { }
+    void startArray(ElementPath path) { }
+    void endArray(ElementPath path) { }
+    void whitespace(char c) { }
+
+    void value(ElementPath path, ElementValue value) {
+      char fullPath[200] = "";
+      char valueText[50];
+      path.toString(fullPath);
+      Serial.print(fullPath);
+      Serial.print(": ");
+      Serial.println(value.toString(valueText, sizeof(valueText)));
+    }
+};
+
+const char json[] = "{\"list\": [{\"temp\": 21.5, \"rain\": false}, {\"temp\": 19.25, \"rain\": true}], "
+                    "\"city\": \"Zurich\"}";
+
+char logBuffer[256];
+JsonSink logSink(logBuffer, sizeof(logBuffer));
+
+JsonStreamingParser parser;
+StaticJsonEventRecorder<16, 64> recorder(&logSink);
+
+// keys and strings are read in place from logBuffer
+StaticJsonEventReplayer<16, 1, 1, 8, 16> replayer;
+PrintingHandler handler;
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  parser.setHandler(&recorder);
+  parser.parse(json, sizeof(json) - 1);
+  Serial.print(sizeof(json) - 1);
+  Serial.print(" JSON bytes recorded as ");
+  Serial.print(logSink.getLength());
+  Serial.println(" log bytes");
+
+  for (int i = 0; i < 2; i++) {
+    if (!replayer.replay((const uint8_t*) logSink.getData(), logSink.getLength(), &handler)) {
+      Serial.println(replayer.getErrorMessage());
+    }
+  }
+}
+
+void loop() {
+}
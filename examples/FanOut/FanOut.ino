@@ -0,0 +1,111 @@
+/* 
+ * Example feeding one parse of a response to several independent handlers.
+ *
+ * Note: Each handler only sees the subtrees it registered for, and the parser
+ *       skips the ones nobody asked for ("hourly" here) without tracking paths
+ *       or buffering strings in them.
+ */
+#include "JsonStreamingParser2.h"
+#include "JsonFanOut.h"
+#include "JsonHandler.h"
+
+const char json[] =
+  "{\"city\": {\"name\": \"Zurich\", \"id\": 2657896},"
+  " \"current\": {\"temp\": 21.5, \"wind\": 12.0},"
+  " \"alerts\": [{\"event\": \"Thunderstorm\", \"severity\": 3}],"
+  " \"hourly\": [{\"dt\": 1, \"temp\": 21.0}, {\"dt\": 2, \"temp\": 20.5}]}";
+
+// Keeps the latest temperature for a display
+class UiCache: public JsonHandler {
+  public:
+    float temp = 0;
+
+    void startDocument() { }
+    void endDocument() { }
+    void startObject(ElementPath path) { }
+    void endObject(ElementPath path) { }
+    void startArray(ElementPath path) { }
+    void endArray(ElementPath path) { }
+    void whitespace(char c) { }
+
+    void value(ElementPath path, ElementValue value) {
+      if (strcmp(path.getKey(), "temp") == 0) {
+        temp = value.getFloat();
+      }
+    }
+};
+
+// Prints everything it gets
+class Logger: public JsonHandler {
+  public:
+    void startDocument() { Serial.println("log: start"); }
+    void endDocument() { Serial.println("log: end"); }
+    void startObject(ElementPath path) { }
+    void endObject(ElementPath path) { }
+    void startArray(ElementPath path) { }
+    void endArray(ElementPath path) { }
+    void whitespace(char c) { }
+
+    void value(ElementPath path, ElementValue value) {
+      char fullPath[100] = "";
+      char valueText[50];
+      path.toString(fullPath);
+      Serial.print("log: ");
+      Serial.print(fullPath);
+      Serial.print(" = ");
+      Serial.println(value.toString(valueText, sizeof(valueText)));
+    }
+};
+
+// Counts severe alerts
+class AlertChecker: public JsonHandler {
+  public:
+    int severe = 0;
+
+    void startDocument() { severe = 0; }
+    void endDocument() { }
+    void startObject(ElementPath path) { }
+    void endObject(ElementPath path) { }
+    void startArray(ElementPath path) { }
+    void endArray(ElementPath path) { }
+    void whitespace(char c) { }
+
+    void value(ElementPath path, ElementValue value) {
+      if (strcmp(path.getKey(), "severity") == 0 && value.getInt() >= 3) {
+        severe++;
+      }
+    }
+};
+
+UiCache cache;
+Logger logger;
+AlertChecker alerts;
+
+JsonFanOut fanOut;
+JsonStreamingParser parser;
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  fanOut.add(&cache, "current");
+  fanOut.add(&logger, "city");
+  fanOut.add(&logger, "alerts[].event");
+  fanOut.add(&alerts, "alerts[]");
+  fanOut.setParser(&parser);
+  parser.setHandler(&fanOut);
+
+  parser.parse(json, sizeof(json) - 1);
+  if (parser.hasParseError()) {
+    Serial.println(parser.getErrorMessage());
+    return;
+  }
+
+  Serial.print("Temperature: ");
+  Serial.println(cache.temp);
+  Serial.print("Severe alerts: ");
+  Serial.println(alerts.severe);
+}
+
+void loop() {
+}
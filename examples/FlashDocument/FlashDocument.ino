@@ -0,0 +1,104 @@
+/* 
+ * Example parsing a static lookup document straight from flash.
+ *
+ * Note: The document never gets copied to RAM. JsonFlashReader reads it in
+ *       aligned 32-bit words through a 64 byte window, and the handler keeps
+ *       flash pointers to the names rather than copies of them.
+ */
+#include "JsonStreamingParser2.h"
+#include "JsonFlashReader.h"
+#include "JsonHandler.h"
+
+static const char countries[] PROGMEM =
+  "{\"countries\": ["
+    "{\"code\": 36, \"name\": \"Australia\"},"
+    "{\"code\": 124, \"name\": \"Canada\"},"
+    "{\"code\": 250, \"name\": \"France\"},"
+    "{\"code\": 276, \"name\": \"Germany\"},"
+    "{\"code\": 392, \"name\": \"Japan\"},"
+    "{\"code\": 756, \"name\": \"Switzerland\"}"
+  "]}";
+
+#define MAX_COUNTRIES 8
+
+struct Country {
+  int code;
+  const char* name;    // in flash, not NUL-terminated
+  size_t nameLength;
+};
+
+class CountryHandler: public JsonHandler {
+  public:
+    Country list[MAX_COUNTRIES];
+    int count = 0;
+
+    void startDocument() { count = 0; }
+    void endDocument() { }
+    void startObject(ElementPath path) { }
+    void endObject(ElementPath path) {
+      if (path.getCount() == 2 && count < MAX_COUNTRIES) {
+        count++;
+      }
+    }
+    void startArray(ElementPath path) { }
+    void endArray(ElementPath path) { }
+    void whitespace(char c) { }
+
+    void value(ElementPath path, ElementValue value) {
+      if (path.getCount() != 3 || count >= MAX_COUNTRIES) {
+        return;
+      }
+      const char* key = path.getKey();
+      if (strcmp(key, "code") == 0) {
+        list[count].code = value.getInt();
+      } else if (strcmp(key, "name") == 0) {
+        // names without escapes come with their flash address
+        list[count].name = value.getStringSource();
+        list[count].nameLength = value.getStringLength();
+      }
+    }
+};
+
+void printFlash(const char* text, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    Serial.print((char) pgm_read_byte(text + i));
+  }
+}
+
+StaticJsonStreamingParser<32, 6, 4, 12> parser;
+CountryHandler handler;
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  parser.setHandler(&handler);
+  JsonFlashReader reader(countries);
+  uint32_t start = micros();
+  reader.pump(&parser);
+  uint32_t elapsed = micros() - start;
+  if (parser.hasParseError()) {
+    Serial.print("Error at byte ");
+    Serial.print(reader.getPosition());
+    Serial.print(": ");
+    Serial.println(parser.getErrorMessage());
+    return;
+  }
+
+  Serial.print("Parsed ");
+  Serial.print(reader.getPosition());
+  Serial.print(" bytes from flash in ");
+  Serial.print(elapsed);
+  Serial.println(" us");
+  for (int i = 0; i < handler.count; i++) {
+    Serial.print(handler.list[i].code);
+    Serial.print(": ");
+    if (handler.list[i].name != nullptr) {
+      printFlash(handler.list[i].name, handler.list[i].nameLength);
+    }
+    Serial.println();
+  }
+}
+
+void loop() {
+}
@@ -0,0 +1,65 @@
+/* 
+ * Example showing the RAM footprint of the parser classes, and how many mostly idle
+ * parsers (think long-poll connections) can share a few scratch buffers instead of
+ * each owning a worst-case one.
+ */ 
+#include "JsonStreamingParser2.h" 
+#include "JsonScratchPool.h"
+#include "JsonHandler.h"
+
+// Fails to compile if a future change bloats the default parser
+static_assert(JsonParserFootprint::PARSER <= 1200, "JsonStreamingParser grew unexpectedly");
+
+class CountingHandler: public JsonHandler {
+  public:
+    int values = 0;
+
+    void startDocument() { }
+    void endDocument() { }
+    void startObject(ElementPath path) { }
+    void endObject(ElementPath path) { }
+    void startArray(ElementPath path) { }
+    void endArray(ElementPath path) { }
+    void value(ElementPath path, ElementValue value) { values++; }
+    void whitespace(char c) { }
+};
+
+// 2 shared 128-byte buffers...
+StaticJsonScratchPool<128, 2> pool;
+
+// ...for 16 parsers without their own buffer (buffer size 0)
+StaticJsonStreamingParser<0, 8, 8, 16> parsers[16];
+
+CountingHandler handler;
+
+void setup() {
+  Serial.begin(115200);
+
+  JsonParserFootprint::print(Serial);
+  Serial.print("Pooled parser: ");
+  Serial.println((unsigned long) sizeof(parsers[0]));
+
+  for (int i = 0; i < 16; i++) {
+    parsers[i].setHandler(&handler);
+    parsers[i].setScratchPool(&pool);
+  }
+
+  // Every parser gets a chunk in turn; a buffer is only held while a string,
+  // number or literal is open, so chunks ending between tokens hold none.
+  const char* chunks[] = { "{\"mykey\":100,", " \"b\":{\"c\":\"d\"},", " \"e\":[true,null]}" };
+  for (int c = 0; c < 3; c++) {
+    for (int p = 0; p < 16; p++) {
+      for (int i = 0; chunks[c][i] != '\0'; i++) {
+        parsers[p].parse(chunks[c][i]);
+      }
+    }
+  }
+
+  Serial.print("Values parsed: ");
+  Serial.println(handler.values);
+  Serial.print("Free pool buffers: ");
+  Serial.println(pool.getFreeCount());
+}
+
+void loop() {
+}
@@ -0,0 +1,105 @@
+/* 
+ * Example overlapping TLS decryption and JSON parsing on the two cores of an ESP32.
+ *
+ * loop() (core 1) decrypts the response straight into a lock-free ring buffer, while a
+ * task pinned to core 0 parses it in place. When the parser falls behind, the ring
+ * buffer fills up and the reading side simply waits for space.
+ *
+ * Note: The response is read raw with HTTP/1.0 so there is no chunked encoding to
+ *       remove (see JsonHttpBodyReader for that).
+ */
+
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+
+#include <JsonRingBuffer.h>
+#include <JsonHandler.h>
+
+class CountingHandler: public JsonHandler {
+  public:
+    uint32_t values = 0;
+
+    void startDocument() { }
+    void endDocument() { }
+    void startObject(ElementPath path) { }
+    void endObject(ElementPath path) { }
+    void startArray(ElementPath path) { }
+    void endArray(ElementPath path) { }
+    void value(ElementPath path, ElementValue value) { values++; }
+    void whitespace(char c) { }
+};
+
+StaticJsonRingBuffer<8192> ring;
+JsonStreamingParser parser;
+CountingHandler handler;
+volatile bool parsed = false;
+
+void parseTask(void* arg) {
+  while (!ring.isFinished() && !parser.isDocumentComplete() && !parser.hasParseError()) {
+    if (ring.pump(&parser) == 0) {
+      vTaskDelay(1);
+    }
+  }
+  parsed = true;
+  vTaskDelete(NULL);
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  WiFi.begin("<SSID>", "<PASSWORD>");
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(500);
+    Serial.print(".");
+  }
+  Serial.println();
+
+  WiFiClientSecure client;
+  client.setInsecure();
+  HTTPClient http;
+  http.useHTTP10(true);
+  http.begin(client, "https://tty.us.to/iot/bigjson.php");
+
+  int httpCode = http.GET();
+  if (httpCode != HTTP_CODE_OK) {
+    Serial.printf("[HTTP] GET... failed, code: %d\n", httpCode);
+    return;
+  }
+
+  parser.setHandler(&handler);
+  xTaskCreatePinnedToCore(parseTask, "parse", 4096, NULL, 1, NULL, 0);
+
+  uint32_t start = millis();
+  WiFiClient* stream = http.getStreamPtr();
+  while (!parsed && (stream->connected() || stream->available())) {
+    char* region;
+    size_t free = ring.reserve(&region);
+    int available = stream->available();
+    if (free == 0 || available <= 0) {
+      // ring buffer full (backpressure) or nothing received yet
+      delay(1);
+      continue;
+    }
+    // decrypted in place, no intermediate buffer
+    int length = stream->read((uint8_t*) region, free < (size_t) available ? free : available);
+    if (length > 0) {
+      ring.commit(length);
+    }
+  }
+  ring.close();
+  while (!parsed) {
+    delay(1);
+  }
+  http.end();
+
+  if (parser.hasParseError()) {
+    Serial.println(parser.getErrorMessage());
+  } else {
+    Serial.printf("%lu values in %lu ms.\n", (unsigned long) handler.values, (unsigned long) (millis() - start));
+  }
+}
+
+void loop() {
+}
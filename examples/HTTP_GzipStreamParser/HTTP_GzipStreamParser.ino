@@ -0,0 +1,77 @@
+/* 
+ * Example requesting a gzip compressed JSON document and parsing it while it is being
+ * decompressed, straight from the WiFi receive buffers.
+ *
+ * Note: Compressed responses are typically 5-10x smaller, which saves a lot of radio time.
+ *       The decompressed bytes pass through a window of (here) 16 KB; documents compressed
+ *       with references further back than that are reported as an error, so use a 32 KB
+ *       window if you have the RAM. Uncompressed responses are parsed as usual.
+ */
+
+#include <ESP8266WiFi.h>
+#include <WiFiClient.h>
+#include <ESP8266HTTPClient.h>
+
+#include <JsonInflater.h>
+#include <JsonHandler.h>
+
+class CountingHandler: public JsonHandler {
+  public:
+    uint32_t values = 0;
+
+    void startDocument() { }
+    void endDocument() { }
+    void startObject(ElementPath path) { }
+    void endObject(ElementPath path) { }
+    void startArray(ElementPath path) { }
+    void endArray(ElementPath path) { }
+    void value(ElementPath path, ElementValue value) { values++; }
+    void whitespace(char c) { }
+};
+
+WiFiClient client;
+HTTPClient http;
+
+JsonStreamingParser parser;
+CountingHandler handler;
+StaticJsonInflateStream<16384> inflater(&parser);
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  WiFi.begin("<SSID>", "<KEY>");
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(500);
+    Serial.print(".");
+  }
+  Serial.println();
+
+  parser.setHandler(&handler);
+
+  http.begin(client, "http://tty.us.to/iot/bigjson.php");
+  // HTTP/1.0 keeps the client from sending its own "Accept-Encoding: identity"
+  http.useHTTP10(true);
+  http.addHeader("Accept-Encoding", "gzip");
+
+  int httpCode = http.GET();
+  if (httpCode == HTTP_CODE_OK) {
+    // the format (gzip, zlib or plain) is detected from the first bytes
+    http.writeToStream(&inflater);
+
+    JsonInflater& decoder = inflater.getInflater();
+    if (decoder.hasInflateError()) {
+      Serial.println(decoder.getErrorMessage());
+    } else {
+      Serial.printf("%lu bytes received, %lu bytes parsed, %lu values.\n",
+                    (unsigned long) decoder.getInputCount(), (unsigned long) decoder.getOutputCount(),
+                    (unsigned long) handler.values);
+    }
+  } else {
+    Serial.printf("[HTTP] GET... failed, code: %d\n", httpCode);
+  }
+  http.end();
+}
+
+void loop() {
+}
@@ -0,0 +1,76 @@
+/* 
+ * Example parsing an HTTP response body straight out of the WiFi client, without the
+ * extra copy made by http.writeToStream(), and closing the connection as soon as the
+ * document has been parsed.
+ *
+ * Note: On ESP8266 core 3 and later the parser reads the client's receive buffer in
+ *       place. Chunked responses (the default with HTTP/1.1) are decoded on the fly.
+ */
+
+#include <ESP8266WiFi.h>
+#include <WiFiClient.h>
+#include <ESP8266HTTPClient.h>
+
+#include <JsonHttpBodyReader.h>
+#include <JsonHandler.h>
+
+class CountingHandler: public JsonHandler {
+  public:
+    uint32_t values = 0;
+
+    void startDocument() { }
+    void endDocument() { }
+    void startObject(ElementPath path) { }
+    void endObject(ElementPath path) { }
+    void startArray(ElementPath path) { }
+    void endArray(ElementPath path) { }
+    void value(ElementPath path, ElementValue value) { values++; }
+    void whitespace(char c) { }
+};
+
+WiFiClient client;
+HTTPClient http;
+
+JsonStreamingParser parser;
+CountingHandler handler;
+JsonHttpBodyReader body(&parser);
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  WiFi.begin("<SSID>", "<KEY>");
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(500);
+    Serial.print(".");
+  }
+  Serial.println();
+
+  parser.setHandler(&handler);
+
+  http.begin(client, "http://tty.us.to/iot/bigjson.php");
+  const char* headers[] = { "Transfer-Encoding" };
+  http.collectHeaders(headers, 1);
+
+  int httpCode = http.GET();
+  if (httpCode == HTTP_CODE_OK) {
+    body.setChunked(http.header("Transfer-Encoding") == "chunked");
+    body.setContentLength(http.getSize());
+
+    if (body.read(*http.getStreamPtr())) {
+      Serial.printf("%lu body bytes read, %lu values.\n",
+                    (unsigned long) body.getBodyCount(), (unsigned long) handler.values);
+    } else if (body.hasReadError()) {
+      Serial.println(body.getErrorMessage());
+    } else {
+      Serial.println("Incomplete document");
+    }
+  } else {
+    Serial.printf("[HTTP] GET... failed, code: %d\n", httpCode);
+  }
+  // drops whatever is left of the transfer
+  http.end();
+}
+
+void loop() {
+}
@@ -0,0 +1,52 @@
+/* 
+ * Example minifying a document before storing or forwarding it, and
+ * re-indenting it for a human to read.
+ *
+ * Note: Strings and numbers are copied byte for byte, escapes included; only
+ *       the whitespace between tokens changes. The minifier does not check
+ *       the syntax, so validate untrusted documents first.
+ */
+#include "JsonStreamingParser2.h"
+#include "JsonMinifier.h"
+
+const char json[] =
+  "{\n"
+  "  \"city\" : { \"name\" : \"Z\\u00fcrich\", \"id\" : 2657896 },\n"
+  "  \"current\" : { \"temp\" : 21.50, \"wind\" : 1.2e1 },\n"
+  "  \"alerts\" : [ ]\n"
+  "}\n";
+
+JsonStreamingParser parser;
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  if (!parser.validate(json, sizeof(json) - 1)) {
+    Serial.println(parser.getErrorMessage());
+    return;
+  }
+
+  // into a buffer, e.g. to be written to flash in one go
+  char minified[128];
+  JsonSink bufferSink(minified, sizeof(minified));
+  JsonMinifier minifier(&bufferSink);
+  minifier.write((const uint8_t*) json, sizeof(json) - 1);
+  Serial.print("Minified from ");
+  Serial.print(sizeof(json) - 1);
+  Serial.print(" to ");
+  Serial.print(bufferSink.getLength());
+  Serial.println(" bytes:");
+  Serial.write((const uint8_t*) minified, bufferSink.getLength());
+  Serial.println();
+
+  // re-indented with 2 spaces straight to Serial
+  JsonSink serialSink(&Serial);
+  JsonMinifier indenter(&serialSink, 2);
+  indenter.write((const uint8_t*) minified, bufferSink.getLength());
+  indenter.flush();
+  Serial.println();
+}
+
+void loop() {
+}
@@ -0,0 +1,180 @@
+/* 
+ * Example resuming an interrupted download of a large JSON document instead of
+ * starting over from byte 0.
+ *
+ * While parsing, the parser state (plus the handler's own state) is checkpointed into
+ * RTC memory every few KB. When the connection drops, or after a reset/deep sleep, the
+ * download is restarted with a "Range: bytes=N-" header from the last checkpoint and
+ * parsing carries on exactly where it stopped.
+ *
+ * Note: The server has to support range requests (reply 206 Partial Content). If it
+ *       replies 200 instead, the whole document is parsed again from the start.
+ *       On the ESP32, keep the checkpoint in a RTC_DATA_ATTR variable instead of using
+ *       ESP.rtcUserMemoryRead/Write.
+ */
+
+#include <ESP8266WiFi.h>
+#include <WiFiClient.h>
+#include <ESP8266HTTPClient.h>
+
+#include <ArduinoStreamParser.h>
+
+#define URL "http://tty.us.to/iot/bigjson.php"
+#define CHECKPOINT_EVERY 4096
+
+// Sized so that a checkpoint fits the 512 bytes of ESP8266 RTC user memory
+typedef StaticArduinoStreamParser<96, 12, 12, 16> ResumableParser;
+
+class CountingHandler: public JsonHandler {
+  public:
+    // everything the handler needs to carry on also goes into the checkpoint
+    uint32_t values = 0;
+    bool done = false;
+
+    void startDocument() { }
+    void endDocument() { done = true; }
+    void startObject(ElementPath path) { }
+    void endObject(ElementPath path) { }
+    void startArray(ElementPath path) { }
+    void endArray(ElementPath path) { }
+    void value(ElementPath path, ElementValue value) { values++; }
+    void whitespace(char c) { }
+};
+
+struct Checkpoint {
+  uint32_t magic;
+  uint32_t values;
+  uint32_t stateLength;
+  uint8_t state[400];
+};
+
+#define CHECKPOINT_MAGIC 0x4A534331
+
+WiFiClient client;
+HTTPClient http;
+ResumableParser parser;
+CountingHandler handler;
+Checkpoint checkpoint;
+
+void saveCheckpoint() {
+  checkpoint.stateLength = parser.saveState(checkpoint.state, sizeof(checkpoint.state));
+  if (checkpoint.stateLength == 0) {
+    return;
+  }
+  checkpoint.magic = CHECKPOINT_MAGIC;
+  checkpoint.values = handler.values;
+  ESP.rtcUserMemoryWrite(0, (uint32_t*) &checkpoint, sizeof(checkpoint));
+}
+
+void clearCheckpoint() {
+  checkpoint.magic = 0;
+  ESP.rtcUserMemoryWrite(0, (uint32_t*) &checkpoint, sizeof(checkpoint));
+}
+
+/*
+  Restores the last checkpoint, if any, and returns the byte offset to
+  continue from.
+*/
+uint32_t loadCheckpoint() {
+  ESP.rtcUserMemoryRead(0, (uint32_t*) &checkpoint, sizeof(checkpoint));
+  if (checkpoint.magic != CHECKPOINT_MAGIC
+      || !parser.restoreState(checkpoint.state, checkpoint.stateLength)) {
+    parser.reset();
+    handler.values = 0;
+    return 0;
+  }
+  handler.values = checkpoint.values;
+  return parser.getCharacterCount();
+}
+
+/*
+  Requests the document from the given byte offset on. Returns true if the
+  response body starts there; if the server ignored the range (or on the
+  first attempt) the parser is reset and the body is the whole document.
+*/
+bool beginRangeRequest(uint32_t offset) {
+  http.begin(client, URL);
+  if (offset > 0) {
+    char range[24];
+    sprintf(range, "bytes=%lu-", (unsigned long) offset);
+    http.addHeader("Range", range);
+  }
+
+  int httpCode = http.GET();
+  if (offset > 0 && httpCode == HTTP_CODE_PARTIAL_CONTENT) {
+    return true;
+  }
+  if (httpCode == HTTP_CODE_OK) {
+    parser.reset();
+    handler.values = 0;
+    return true;
+  }
+  Serial.printf("[HTTP] GET... failed, code: %d\n", httpCode);
+  http.end();
+  return false;
+}
+
+/*
+  Feeds the response body to the parser until the document ends or the
+  connection drops, checkpointing along the way.
+*/
+void parseBody() {
+  WiFiClient* stream = http.getStreamPtr();
+  uint8_t chunk[128];
+  uint32_t nextCheckpoint = parser.getCharacterCount() + CHECKPOINT_EVERY;
+
+  while (!handler.done && !parser.hasParseError() && (stream->connected() || stream->available())) {
+    size_t length = stream->readBytes(chunk, sizeof(chunk));
+    if (length == 0) {
+      continue;
+    }
+    parser.write(chunk, length);
+    if (parser.getCharacterCount() >= nextCheckpoint) {
+      saveCheckpoint();
+      nextCheckpoint = parser.getCharacterCount() + CHECKPOINT_EVERY;
+    }
+  }
+  // bytes parsed after the last checkpoint are not lost either
+  if (!handler.done) {
+    saveCheckpoint();
+  }
+  http.end();
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  WiFi.begin("<SSID>", "<KEY>");
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(500);
+    Serial.print(".");
+  }
+  Serial.println();
+
+  parser.setHandler(&handler);
+
+  for (int attempt = 0; attempt < 10 && !handler.done && !parser.hasParseError(); attempt++) {
+    uint32_t offset = loadCheckpoint();
+    Serial.printf("Downloading from byte %lu\n", (unsigned long) offset);
+    if (beginRangeRequest(offset)) {
+      parseBody();
+    } else {
+      delay(1000);
+    }
+  }
+
+  if (handler.done) {
+    Serial.printf("Completed, %lu values.\n", (unsigned long) handler.values);
+    clearCheckpoint();
+  } else if (parser.hasParseError()) {
+    Serial.println(parser.getErrorMessage());
+    clearCheckpoint();
+  } else {
+    Serial.println("Giving up for now, will resume after deep sleep.");
+    ESP.deepSleep(60e6);
+  }
+}
+
+void loop() {
+}
@@ -0,0 +1,52 @@
+/* 
+ * Example of declarative struct binding: instead of writing a value() state machine,
+ * declare which JSON path goes into which struct member and let JsonStructBinder
+ * fill the structs while the document streams through the parser.
+ */ 
+#include "JsonStreamingParser2.h" 
+#include "JsonBinding.h"
+
+struct Forecast
+{
+    long    datetime;
+    int     temp;
+    int     humidity;
+    char    summary[16];
+};
+
+// Path -> member table, hashed and resolved at compile time
+static const JsonFieldBinding forecastFields[] = {
+    JSON_BIND(Forecast, datetime, "list[].dt"),
+    JSON_BIND(Forecast, temp,     "list[].main.temp"),
+    JSON_BIND(Forecast, humidity, "list[].main.humidity"),
+    JSON_BIND(Forecast, summary,  "list[].weather[].main")   // first weather entry only
+};
+
+Forecast forecasts[4];
+
+JsonStreamingParser parser;
+JsonStructBinder<Forecast> binder(forecastFields, forecasts, 4);
+
+void setup() {
+  Serial.begin(115200);
+
+  parser.setHandler(&binder);
+
+  char json[] = "{\"cnt\":2,\"list\":["
+                "{\"dt\":1487246400,\"main\":{\"temp\":286,\"humidity\":75},\"weather\":[{\"main\":\"Clear\"}]},"
+                "{\"dt\":1487257200,\"main\":{\"temp\":283,\"humidity\":80},\"weather\":[{\"main\":\"Clouds\"},{\"main\":\"Rain\"}]}"
+                "]}";
+
+  for (int i = 0; json[i] != '\0'; i++) {
+    parser.parse(json[i]);
+  }
+
+  for (int i = 0; i < binder.getCount(); i++) {
+    Serial.printf("Forecast %d: dt=%ld temp=%d humidity=%d summary=%s\n",
+                  i, forecasts[i].datetime, forecasts[i].temp, forecasts[i].humidity, forecasts[i].summary);
+  }
+}
+
+void loop() {
+  // put your main code here, to run repeatedly:
+}
@@ -35,6 +35,14 @@ void setup() {
   char invalidJson2[] = "{\"mykey\":100, \"invalid\":@}";
   parseJsonString(invalidJson2, "Invalid JSON (bad character)");
   
+  // Test closers that do not match the open container
+  Serial.println("\n=== Testing Mismatched Closers ===");
+  const char* mismatched[] = { "[1}", "[\"a\"}", "[true}", "{\"a\":[1}}", "{\"a\":1]" };
+  for (const char* json : mismatched) {
+    parser.reset();
+    parseJsonString(json, json);   // "Expected ',' or ']'/'}' while parsing array/object"
+  }
+  
   // Test very long string that would cause buffer overflow
   Serial.println("\n=== Testing Buffer Overflow Protection ===");
   parser.reset();
@@ -0,0 +1,57 @@
+/*
+  Desktop tool printing the shape profile of JSON documents (see
+  JsonShapeProfiler), to size the parser for them before flashing:
+
+    g++ -O2 -Iextras/ShapeProfiler/host -Isrc -o shape-profiler extras/ShapeProfiler/ShapeProfiler.cpp \
+        src/ElementPath.cpp src/JsonDigits.cpp src/JsonHandler.cpp src/JsonParserStats.cpp \
+        src/JsonPathHash.cpp src/JsonScratchPool.cpp src/JsonShapeProfiler.cpp src/JsonStreamingParser2.cpp
+    ./shape-profiler response.json [more.json ...]       (or from stdin)
+
+  Documents may be concatenated; all of them go into one profile.
+*/
+
+#include "JsonShapeProfiler.h"
+
+static StaticJsonStreamingParser<65535, 255, 250, 250> parser;
+// key text is addressed by 16-bit offsets: 65535 bytes at most
+static StaticJsonShapeProfiler<4096, 65535, 250> profiler;
+
+static bool profile(FILE* in, const char* name) {
+  char chunk[4096];
+  size_t length;
+  while ((length = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+    size_t i = 0;
+    while (i < length) {
+      i += parser.parse(chunk + i, length - i);
+      if (parser.hasParseError()) {
+        fprintf(stderr, "%s: %s at byte %lu\n", name, parser.getErrorMessage(), (unsigned long) parser.getCharacterCount());
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  parser.setHandler(&profiler);
+  profiler.setParser(&parser);
+
+  bool ok = true;
+  if (argc < 2) {
+    ok = profile(stdin, "stdin");
+  }
+  for (int i = 1; i < argc && ok; i++) {
+    FILE* in = fopen(argv[i], "rb");
+    if (in == NULL) {
+      perror(argv[i]);
+      return 2;
+    }
+    parser.reset();
+    ok = profile(in, argv[i]);
+    fclose(in);
+  }
+
+  FilePrint out(stdout);
+  profiler.print(out);
+  return ok ? 0 : 1;
+}
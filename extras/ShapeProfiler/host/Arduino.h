@@ -0,0 +1,71 @@
+#ifndef SHAPE_PROFILER_HOST_ARDUINO_H
+#define SHAPE_PROFILER_HOST_ARDUINO_H
+
+/*
+  The few Arduino core pieces the parser and the profiler use, so that
+  they build on a desktop for the ShapeProfiler tool.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+inline unsigned long millis() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000UL + now.tv_nsec / 1000000;
+}
+
+inline unsigned long micros() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+}
+
+typedef bool boolean;
+
+inline void yield() { }
+
+class Print {
+  public:
+    virtual ~Print() { }
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+      size_t n = 0;
+      while (n < size && write(buffer[n])) {
+        n++;
+      }
+      return n;
+    }
+
+    size_t print(const char* text) { return write((const uint8_t*) text, strlen(text)); }
+    size_t print(char c) { return write((uint8_t) c); }
+    size_t print(int value) { return print((long) value); }
+    size_t print(unsigned int value) { return print((unsigned long) value); }
+    size_t print(long value) { char text[24]; snprintf(text, sizeof(text), "%ld", value); return print(text); }
+    size_t print(unsigned long value) { char text[24]; snprintf(text, sizeof(text), "%lu", value); return print(text); }
+    size_t print(double value, int digits = 2) { char text[48]; snprintf(text, sizeof(text), "%.*f", digits, value); return print(text); }
+
+    size_t println() { return print("\n"); }
+
+    template <class T> size_t println(T value) { size_t n = print(value); return n + println(); }
+};
+
+class FilePrint: public Print {
+  private:
+    FILE* file;
+
+  public:
+    FilePrint(FILE* file) : file(file) { }
+
+    virtual size_t write(uint8_t c) { return fputc(c, file) == EOF ? 0 : 1; }
+
+    virtual size_t write(const uint8_t* buffer, size_t size) { return fwrite(buffer, 1, size, file); }
+};
+
+#endif // SHAPE_PROFILER_HOST_ARDUINO_H
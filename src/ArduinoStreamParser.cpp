@@ -1,38 +1,43 @@
 #include "ArduinoStreamParser.h"
 
-size_t ArduinoStreamParser::write(uint8_t data) 
+size_t JsonParserStream::write(uint8_t data) 
 {
-	parse(data);
+	target->parse(data);
 
-	return 1;
+	return target->hasParseError() ? 0 : 1;
 }
 
-size_t ArduinoStreamParser::write(const uint8_t *buffer, size_t size)
+size_t JsonParserStream::write(const uint8_t *buffer, size_t size)
 {
-	for (unsigned int i = 0; i < size; i++) {
-		parse(buffer[i]);
+	// keeps going after the end of a document, in case another one follows;
+	// stops at the first error so that the writer stops sending
+	size_t consumed = 0;
+	while (consumed < size && !target->hasParseError()) {
+		consumed += target->parse((const char*) buffer + consumed, size - consumed);
 	}
-	//parse(data);
-		
-	return size;
+	return consumed;
 }
 
-int ArduinoStreamParser::available() {
+int JsonParserStream::available() {
 	
     return 1;
 }
 
-int ArduinoStreamParser::read() {
+int JsonParserStream::read() {
 	
     return 0;
 }
 
-int ArduinoStreamParser::peek() {
+int JsonParserStream::peek() {
 	
     return 0;
 }
 
-void ArduinoStreamParser::flush() {
+void JsonParserStream::clear() {
+	target->reset();
+}
+
+void JsonParserStream::flush() {
 	
   
 }
\ No newline at end of file
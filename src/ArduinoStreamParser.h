@@ -9,8 +9,17 @@
 // Can set this to 1
 #define CHARS_TO_PARSE_EACH_TIME 32
 
-class ArduinoStreamParser: public Stream, public JsonStreamingParser  {
+/*
+  Stream front-end feeding whatever is written to it into a parser, e.g.
+  http.writeToStream(&stream). It works with any parser, including ones
+  built over caller-provided storage.
+*/
+class JsonParserStream: public Stream {
+private:
+    JsonStreamingParserBase* target;
+
 public:
+    JsonParserStream(JsonStreamingParserBase* parser) : target(parser) { }
 
     /** Clear the buffer */
     void clear(); 
@@ -26,8 +35,27 @@ public:
 
     virtual int availableForWrite() { return CHARS_TO_PARSE_EACH_TIME; }    // 32 bytes at a go? Can set this to 1
     virtual bool outputCanTimeout () { return false; }
+};
 
+/*
+  Stream front-end with an embedded parser sized by template arguments
+  (see StaticJsonStreamingParser).
+*/
+template <int BUFFER_SIZE, int STACK_DEPTH, int PATH_DEPTH, int KEY_LENGTH>
+class StaticArduinoStreamParser: public StaticJsonStreamingParser<BUFFER_SIZE, STACK_DEPTH, PATH_DEPTH, KEY_LENGTH>,
+                                 public JsonParserStream {
+public:
+    // the parser base comes first, so it is constructed before the stream points to it
+    StaticArduinoStreamParser() : JsonParserStream(this) { }
+
+    using JsonParserStream::clear;
+};
 
+/*
+  Stream front-end with an embedded parser sized by the JSON_PARSER_* macros.
+*/
+class ArduinoStreamParser: public StaticArduinoStreamParser<JSON_PARSER_BUFFER_MAX_LENGTH, JSON_PARSER_STACK_MAX_DEPTH,
+                                                            JSON_PARSER_PATH_MAX_DEPTH, JSON_PARSER_KEY_MAX_LENGTH> {
 };
 
 #endif // ARDUINO_STREAM_PARSER_H
@@ -0,0 +1,392 @@
+#include "BinaryStreamingParser.h"
+#include <limits.h>
+#include <math.h>
+
+enum BinaryParserState : uint8_t {
+  BINARY_STATE_HEAD      = 0,
+  BINARY_STATE_ARGUMENT  = 1,
+  BINARY_STATE_STRING    = 2
+};
+
+// BinaryStackEntry::flags
+#define BINARY_ENTRY_MAP         0x01
+#define BINARY_ENTRY_INDEFINITE  0x02
+// the key of the current map pair has been read
+#define BINARY_ENTRY_VALUE_NEXT  0x04
+
+/*
+  Decodes an IEEE 754 binary16 value, or a binary64 one where double is
+  32 bits wide (as on some boards) and it has to be narrowed to float.
+*/
+static float decodeFloat(uint64_t bits, uint8_t exponentBits, uint8_t mantissaBits) {
+  int bias = (1 << (exponentBits - 1)) - 1;
+  int exponent = (int) (bits >> mantissaBits) & ((1 << exponentBits) - 1);
+  uint64_t mantissa = bits & ((1ULL << mantissaBits) - 1);
+  float value;
+  if (exponent == (1 << exponentBits) - 1) {
+    value = mantissa != 0 ? NAN : INFINITY;
+  } else if (exponent == 0) {
+    value = ldexpf((float) mantissa, 1 - bias - mantissaBits);
+  } else {
+    value = ldexpf((float) (mantissa | (1ULL << mantissaBits)), exponent - bias - mantissaBits);
+  }
+  return (bits >> (exponentBits + mantissaBits)) & 1 ? -value : value;
+}
+
+/*
+  Formats an integer map key (printf has no 64-bit support on some boards).
+*/
+static void formatKey(char* key, uint64_t magnitude, bool negative) {
+  char digits[21];
+  int count = 0;
+  do {
+    digits[count++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude > 0);
+  if (negative) {
+    *key++ = '-';
+  }
+  while (count > 0) {
+    *key++ = digits[--count];
+  }
+  *key = '\0';
+}
+
+BinaryStreamingParserBase::BinaryStreamingParserBase(char* buffer, int bufferSize, BinaryStackEntry* stack, int stackSize,
+                                                     ElementSelector* selectors, int pathDepth, char* keys, int keyLength)
+  : path(selectors, pathDepth, keys, pathDepth * keyLength) {
+    this->buffer = buffer;
+    this->bufferSize = bufferSize < 65535 ? bufferSize : 65535;
+    this->stack = stack;
+    this->stackSize = stackSize < 255 ? stackSize : 255;
+    reset();
+}
+
+void BinaryStreamingParserBase::reset() {
+    state = BINARY_STATE_HEAD;
+    path.reset();
+    bufferPos = 0;
+    stringRemaining = 0;
+    argumentRemaining = 0;
+    stackPos = 0;
+    chunkedString = false;
+    hasError = false;
+    documentEnded = false;
+    errorMessage = nullptr;
+}
+
+void BinaryStreamingParserBase::setHandler(JsonHandler* handler) {
+    myHandler = handler;
+}
+
+void BinaryStreamingParserBase::setError(const char* message) {
+    hasError = true;
+    errorMessage = message;
+}
+
+void BinaryStreamingParserBase::parse(char c) {
+    if (hasError) {
+      return;
+    }
+    documentEnded = false;
+    parseByte((uint8_t) c);
+}
+
+size_t BinaryStreamingParserBase::parse(const char* data, size_t length) {
+    size_t i = 0;
+    documentEnded = false;
+#ifdef ARDUINO_ARCH_ESP8266
+    yield();
+#endif
+    while (i < length && !hasError && !documentEnded) {
+      if (state == BINARY_STATE_STRING) {
+        size_t run = length - i;
+        if (run > stringRemaining) {
+          run = stringRemaining;
+        }
+        memcpy(buffer + bufferPos, data + i, run);
+        bufferPos += run;
+        stringRemaining -= run;
+        i += run;
+        if (stringRemaining == 0) {
+          endChunk();
+        }
+        continue;
+      }
+      parseByte((uint8_t) data[i++]);
+    }
+    return i;
+}
+
+void BinaryStreamingParserBase::parseByte(uint8_t c) {
+    switch (state) {
+    case BINARY_STATE_HEAD:
+      decodeHead(c);
+      break;
+    case BINARY_STATE_ARGUMENT:
+      argument = (argument << 8) | c;
+      if (--argumentRemaining == 0) {
+        dispatch();
+      }
+      break;
+    case BINARY_STATE_STRING:
+      buffer[bufferPos++] = c;
+      if (--stringRemaining == 0) {
+        endChunk();
+      }
+      break;
+    }
+}
+
+void BinaryStreamingParserBase::item(BinaryItemKind kind, uint8_t argumentSize, uint32_t immediate) {
+    this->kind = kind;
+    this->argumentSize = argumentSize;
+    if (argumentSize == 0) {
+      argument = immediate;
+      dispatch();
+    } else {
+      argument = 0;
+      argumentRemaining = argumentSize;
+      state = BINARY_STATE_ARGUMENT;
+    }
+}
+
+bool BinaryStreamingParserBase::isKeyNext() const {
+    return stackPos > 0 && (stack[stackPos - 1].flags & (BINARY_ENTRY_MAP | BINARY_ENTRY_VALUE_NEXT)) == BINARY_ENTRY_MAP;
+}
+
+void BinaryStreamingParserBase::dispatch() {
+    state = BINARY_STATE_HEAD;
+    if (chunkedString) {
+      // next chunk of an indefinite length string
+      startString(argument > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) argument);
+      return;
+    }
+    if (kind == BINARY_TAG) {
+      return;
+    }
+    if (stackPos == 0 && kind != BINARY_ARRAY && kind != BINARY_MAP) {
+      setError("Document must start with object or array");
+      return;
+    }
+
+    bool key = isKeyNext();
+    uint64_t magnitude = argument;
+    bool negative = false;
+    switch (kind) {
+    case BINARY_NINT:
+      // -1 - argument (-2^64, which no board can hold anyway, wraps to 0)
+      magnitude = argument + 1;
+      negative = true;
+      break;
+    case BINARY_INT: {
+      uint8_t shift = 64 - 8 * (argumentSize > 0 ? argumentSize : 4);
+      int64_t signedValue = (int64_t) (argument << shift) >> shift;
+      negative = signedValue < 0;
+      magnitude = negative ? 0 - (uint64_t) signedValue : (uint64_t) signedValue;
+    } break;
+    case BINARY_STRING:
+    case BINARY_BYTES:
+      startString(argument > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) argument);
+      return;
+    case BINARY_ARRAY:
+    case BINARY_MAP:
+      if (key) {
+        setError("Map keys must be strings or integers");
+        return;
+      }
+      startContainer(kind == BINARY_MAP, argument > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) argument, false);
+      return;
+    default:
+      break;
+    }
+
+    if (kind <= BINARY_INT) {
+      if (key) {
+        char text[22];
+        formatKey(text, magnitude, negative);
+        if (!path.setKey(text)) {
+          setError("Path overflow - keys too long");
+          return;
+        }
+        stack[stackPos - 1].flags |= BINARY_ENTRY_VALUE_NEXT;
+      } else if (magnitude <= (negative ? (uint64_t) LONG_MAX + 1 : (uint64_t) LONG_MAX)) {
+        value(elementValue.with(negative ? (long) (0 - magnitude) : (long) magnitude));
+      } else {
+        value(elementValue.with(negative ? -(float) magnitude : (float) magnitude));
+      }
+      return;
+    }
+
+    if (key) {
+      setError("Map keys must be strings or integers");
+      return;
+    }
+    switch (kind) {
+    case BINARY_FLOAT16:
+      value(elementValue.with(decodeFloat(argument, 5, 10)));
+      break;
+    case BINARY_FLOAT32: {
+      uint32_t bits = (uint32_t) argument;
+      float floatValue;
+      memcpy(&floatValue, &bits, sizeof(floatValue));
+      value(elementValue.with(floatValue));
+    } break;
+    case BINARY_FLOAT64:
+      if (sizeof(double) == sizeof(argument)) {
+        // kept at double precision, as getDouble() gives it for JSON text
+        double doubleValue;
+        memcpy(&doubleValue, &argument, sizeof(doubleValue));
+        value(elementValue.with(doubleValue));
+      } else {
+        value(elementValue.with(decodeFloat(argument, 11, 52)));
+      }
+      break;
+    case BINARY_FALSE:
+      value(elementValue.with(false));
+      break;
+    case BINARY_TRUE:
+      value(elementValue.with(true));
+      break;
+    default:
+      value(elementValue.with());
+      break;
+    }
+}
+
+void BinaryStreamingParserBase::startIndefinite(BinaryItemKind kind) {
+    if (stackPos == 0 && kind != BINARY_ARRAY && kind != BINARY_MAP) {
+      setError("Document must start with object or array");
+    } else if (kind == BINARY_STRING || kind == BINARY_BYTES) {
+      chunkedString = true;
+      bufferPos = 0;
+    } else if (isKeyNext()) {
+      setError("Map keys must be strings or integers");
+    } else {
+      startContainer(kind == BINARY_MAP, 0, true);
+    }
+}
+
+void BinaryStreamingParserBase::breakIndefinite() {
+    if (chunkedString) {
+      endString();
+      return;
+    }
+    if (stackPos == 0 || !(stack[stackPos - 1].flags & BINARY_ENTRY_INDEFINITE)
+        || (stack[stackPos - 1].flags & BINARY_ENTRY_VALUE_NEXT)) {
+      setError("Unexpected break");
+      return;
+    }
+    endContainer();
+    endValue();
+}
+
+void BinaryStreamingParserBase::startContainer(bool map, uint32_t count, bool indefinite) {
+    if (stackPos == 0) {
+      myHandler->startDocument();
+    }
+    if (map) {
+      myHandler->startObject(path);
+    } else {
+      myHandler->startArray(path);
+    }
+    if (stackPos >= stackSize) {
+      setError("Stack overflow - too deeply nested");
+      return;
+    }
+    if (!path.push()) {
+      setError(path.getCount() < path.getCapacity() ? "Path overflow - keys too long" : "Path overflow - too deeply nested");
+      return;
+    }
+    if (!map) {
+      // the index of the first element
+      path.getCurrent()->step();
+    }
+    stack[stackPos].remaining = count;
+    stack[stackPos].flags = (map ? BINARY_ENTRY_MAP : 0) | (indefinite ? BINARY_ENTRY_INDEFINITE : 0);
+    stackPos++;
+    if (!indefinite && count == 0) {
+      endContainer();
+      endValue();
+    }
+}
+
+void BinaryStreamingParserBase::endContainer() {
+    stackPos--;
+    path.pop();
+    if (stack[stackPos].flags & BINARY_ENTRY_MAP) {
+      myHandler->endObject(path);
+    } else {
+      myHandler->endArray(path);
+    }
+}
+
+void BinaryStreamingParserBase::startString(uint32_t length) {
+    if (length >= (uint32_t) (bufferSize - bufferPos)) {
+      setError("Buffer overflow - string too long");
+      return;
+    }
+    stringRemaining = length;
+    if (length > 0) {
+      state = BINARY_STATE_STRING;
+    } else {
+      endChunk();
+    }
+}
+
+/*
+  End of a string's bytes, or of one chunk of an indefinite length string.
+*/
+void BinaryStreamingParserBase::endChunk() {
+    if (chunkedString) {
+      state = BINARY_STATE_HEAD;
+    } else {
+      endString();
+    }
+}
+
+void BinaryStreamingParserBase::endString() {
+    state = BINARY_STATE_HEAD;
+    buffer[bufferPos] = '\0';
+    chunkedString = false;
+    if (isKeyNext()) {
+      if (path.setKey(buffer, bufferPos)) {
+        stack[stackPos - 1].flags |= BINARY_ENTRY_VALUE_NEXT;
+      } else {
+        setError("Path overflow - keys too long");
+      }
+    } else {
+      value(elementValue.with((const char*) buffer));
+    }
+    bufferPos = 0;
+}
+
+void BinaryStreamingParserBase::value(ElementValue value) {
+    myHandler->value(path, value);
+    endValue();
+}
+
+/*
+  Moves on to the next element of the enclosing array or map, closing
+  those that are complete.
+*/
+void BinaryStreamingParserBase::endValue() {
+    while (stackPos > 0) {
+      BinaryStackEntry& entry = stack[stackPos - 1];
+      if (entry.flags & BINARY_ENTRY_MAP) {
+        entry.flags &= ~BINARY_ENTRY_VALUE_NEXT;
+      } else {
+        path.getCurrent()->step();
+      }
+      if ((entry.flags & BINARY_ENTRY_INDEFINITE) || --entry.remaining > 0) {
+        return;
+      }
+      endContainer();
+    }
+    endDocument();
+}
+
+void BinaryStreamingParserBase::endDocument() {
+    myHandler->endDocument();
+    documentEnded = true;
+}
@@ -0,0 +1,154 @@
+#ifndef BINARY_STREAMING_PARSER_H
+#define BINARY_STREAMING_PARSER_H
+
+#include <Arduino.h>
+#include "JsonHandler.h"
+
+/*
+  Kinds of items, as decoded from an item head by the format specific
+  parsers (see CborStreamingParser and MsgPackStreamingParser).
+*/
+enum BinaryItemKind : uint8_t {
+  BINARY_UINT     = 0,
+  // CBOR negative integer: -1 - argument
+  BINARY_NINT     = 1,
+  // two's complement integer of the argument's size
+  BINARY_INT      = 2,
+  BINARY_FLOAT16  = 3,
+  BINARY_FLOAT32  = 4,
+  BINARY_FLOAT64  = 5,
+  BINARY_STRING   = 6,
+  BINARY_BYTES    = 7,
+  BINARY_ARRAY    = 8,
+  BINARY_MAP      = 9,
+  // CBOR tag: read and ignored, the tagged item follows
+  BINARY_TAG      = 10,
+  BINARY_FALSE    = 11,
+  BINARY_TRUE     = 12,
+  BINARY_NULL     = 13
+};
+
+/*
+  Open array or map. remaining counts elements, or key/value pairs.
+*/
+struct BinaryStackEntry {
+  uint32_t remaining;
+  uint8_t flags;
+};
+
+/*
+  Common logic of the binary input parsers: nesting, element path,
+  string collection and value reporting, so that CBOR and MessagePack
+  documents produce exactly the JsonHandler events their JSON
+  equivalent would (documents are maps or arrays, map keys are strings
+  or integers). Strings and binary numbers are length-prefixed, so
+  nothing is scanned or converted from text.
+
+  Like JsonStreamingParserBase, it works over caller-provided storage
+  and accepts input in arbitrary pieces; after a complete document it
+  starts over with the next one.
+*/
+class BinaryStreamingParserBase {
+  private:
+    ElementPath path;
+
+    JsonHandler* myHandler = nullptr;
+
+    // current string or key
+    char* buffer;
+    BinaryStackEntry* stack;
+
+    const char* errorMessage = nullptr;
+
+    uint64_t argument = 0;
+    uint32_t stringRemaining = 0;
+
+    ElementValue elementValue;
+
+    uint16_t bufferSize;
+    uint16_t bufferPos = 0;
+
+    uint8_t state;
+    uint8_t stackSize;
+    uint8_t stackPos = 0;
+    BinaryItemKind kind = BINARY_UINT;
+    uint8_t argumentSize = 0;
+    uint8_t argumentRemaining = 0;
+
+    bool chunkedString = false;
+    bool hasError = false;
+    bool documentEnded = false;
+
+    void parseByte(uint8_t c);
+
+    void dispatch();
+
+    bool isKeyNext() const;
+
+    void startContainer(bool map, uint32_t count, bool indefinite);
+    void endContainer();
+
+    void startString(uint32_t length);
+    void endChunk();
+    void endString();
+
+    void value(ElementValue value);
+    void endValue();
+
+    void endDocument();
+
+  protected:
+    BinaryStreamingParserBase(char* buffer, int bufferSize, BinaryStackEntry* stack, int stackSize,
+                              ElementSelector* selectors, int pathDepth, char* keys, int keyLength);
+
+    /*
+      Decodes the head of the next item, reporting it through item(),
+      startIndefinite() or breakIndefinite().
+    */
+    virtual void decodeHead(uint8_t head) = 0;
+
+    /*
+      Item whose argument (length, count or value) is the argumentSize
+      bytes that follow, big-endian, or immediate if argumentSize is 0.
+    */
+    void item(BinaryItemKind kind, uint8_t argumentSize, uint32_t immediate = 0);
+
+    /*
+      CBOR indefinite length array, map or string, closed by
+      breakIndefinite(). Indefinite strings arrive as chunks, whose heads
+      are passed to decodeHead() too.
+    */
+    void startIndefinite(BinaryItemKind kind);
+    void breakIndefinite();
+
+    bool isInChunkedString() const { return chunkedString; }
+
+    void setError(const char* message);
+
+  public:
+    void parse(char c);
+
+    /*
+      Bulk input: parses length bytes, stopping at the first error or right
+      after the end of the document. Returns the number of bytes consumed.
+      String contents are copied in one go.
+    */
+    size_t parse(const char* data, size_t length);
+
+    /*
+      True if the last byte parsed ended the document.
+    */
+    bool isDocumentComplete() const { return documentEnded; }
+
+    void setHandler(JsonHandler* handler);
+    void reset();
+
+    bool hasParseError() const { return hasError; }
+    const char* getErrorMessage() const { return errorMessage; }
+
+    int getMaxBufferSize() const { return bufferSize; }
+    int getMaxStackDepth() const { return stackSize; }
+    int getStackDepth() const { return stackPos; }
+};
+
+#endif // BINARY_STREAMING_PARSER_H
@@ -0,0 +1,74 @@
+#include "CborStreamingParser.h"
+
+#define CBOR_MAJOR_BYTES   2
+#define CBOR_MAJOR_TEXT    3
+#define CBOR_MAJOR_SIMPLE  7
+
+#define CBOR_INDEFINITE    31
+#define CBOR_BREAK         0xFF
+
+static const BinaryItemKind majorKinds[] = {
+  BINARY_UINT, BINARY_NINT, BINARY_BYTES, BINARY_STRING, BINARY_ARRAY, BINARY_MAP, BINARY_TAG
+};
+
+void CborStreamingParserBase::decodeHead(uint8_t head) {
+    uint8_t major = head >> 5;
+    uint8_t info = head & 0x1F;
+
+    if (isInChunkedString()) {
+      if (head == CBOR_BREAK) {
+        breakIndefinite();
+      } else if (major != stringMajor || info == CBOR_INDEFINITE) {
+        setError("Invalid chunk in indefinite length string");
+      } else if (info >= 28) {
+        setError("Invalid CBOR item");
+      } else {
+        item(BINARY_STRING, info < 24 ? 0 : 1 << (info - 24), info);
+      }
+      return;
+    }
+
+    if (major == CBOR_MAJOR_SIMPLE) {
+      switch (info) {
+      case 20:
+        item(BINARY_FALSE, 0);
+        break;
+      case 21:
+        item(BINARY_TRUE, 0);
+        break;
+      case 22:
+      case 23:
+        // null and undefined
+        item(BINARY_NULL, 0);
+        break;
+      case 25:
+        item(BINARY_FLOAT16, 2);
+        break;
+      case 26:
+        item(BINARY_FLOAT32, 4);
+        break;
+      case 27:
+        item(BINARY_FLOAT64, 8);
+        break;
+      case CBOR_INDEFINITE:
+        breakIndefinite();
+        break;
+      default:
+        setError("Unsupported CBOR simple value");
+      }
+      return;
+    }
+
+    if (info == CBOR_INDEFINITE) {
+      if (major < CBOR_MAJOR_BYTES || major > 5) {
+        setError("Invalid CBOR item");
+        return;
+      }
+      stringMajor = major;
+      startIndefinite(majorKinds[major]);
+    } else if (info >= 28) {
+      setError("Invalid CBOR item");
+    } else {
+      item(majorKinds[major], info < 24 ? 0 : 1 << (info - 24), info);
+    }
+}
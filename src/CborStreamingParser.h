@@ -0,0 +1,58 @@
+#ifndef CBOR_STREAMING_PARSER_H
+#define CBOR_STREAMING_PARSER_H
+
+#include <Arduino.h>
+#include "BinaryStreamingParser.h"
+#include "JsonStreamingParser2.h"
+
+/*
+  Streaming CBOR (RFC 8949) parser reporting the same JsonHandler events
+  as JsonStreamingParser, so existing handlers take CBOR input as is.
+
+  Integers, floats (half, single and double precision, the latter kept
+  for getDouble() where double is 64 bits wide), booleans,
+  null/undefined, text strings, arrays and maps are supported, with
+  definite or indefinite lengths. Byte strings are reported as strings;
+  tags are skipped. Strings must fit in the buffer (including a
+  terminating '\0').
+*/
+class CborStreamingParserBase: public BinaryStreamingParserBase {
+  private:
+    // major type of the indefinite length string being read
+    uint8_t stringMajor = 0;
+
+  protected:
+    virtual void decodeHead(uint8_t head);
+
+  public:
+    CborStreamingParserBase(char* buffer, int bufferSize, BinaryStackEntry* stack, int stackSize,
+                            ElementSelector* selectors, int pathDepth, char* keys, int keyLength)
+      : BinaryStreamingParserBase(buffer, bufferSize, stack, stackSize, selectors, pathDepth, keys, keyLength) { }
+};
+
+/*
+  CBOR parser embedding its own storage, sized like
+  StaticJsonStreamingParser.
+*/
+template <int BUFFER_SIZE, int STACK_DEPTH, int PATH_DEPTH, int KEY_LENGTH>
+class StaticCborStreamingParser: public CborStreamingParserBase {
+  private:
+    char bufferStorage[BUFFER_SIZE];
+    BinaryStackEntry stackStorage[STACK_DEPTH];
+    ElementSelector selectorStorage[PATH_DEPTH];
+    char keyStorage[PATH_DEPTH * KEY_LENGTH];
+
+  public:
+    StaticCborStreamingParser()
+      : CborStreamingParserBase(bufferStorage, BUFFER_SIZE, stackStorage, STACK_DEPTH,
+                                selectorStorage, PATH_DEPTH, keyStorage, KEY_LENGTH) { }
+};
+
+/*
+  CBOR parser sized by the JSON_PARSER_* macros.
+*/
+class CborStreamingParser: public StaticCborStreamingParser<JSON_PARSER_BUFFER_MAX_LENGTH, JSON_PARSER_STACK_MAX_DEPTH,
+                                                            JSON_PARSER_PATH_MAX_DEPTH, JSON_PARSER_KEY_MAX_LENGTH> {
+};
+
+#endif // CBOR_STREAMING_PARSER_H
@@ -47,17 +47,6 @@ void ElementSelector::set(int index) {
   this->key[0] = '\0';
 }
 
-void ElementSelector::set(char* key) {
-  if (key != nullptr && strlen(key) < JSON_PARSER_KEY_MAX_LENGTH) {
-    strcpy(this->key, key);
-  } else {
-    // Truncate if too long to prevent buffer overflow
-    strncpy(this->key, key, JSON_PARSER_KEY_MAX_LENGTH - 1);
-    this->key[JSON_PARSER_KEY_MAX_LENGTH - 1] = '\0';
-  }
-  this->index = -1;
-}
-
 void ElementSelector::step() {
   index++;
 }
@@ -70,6 +59,13 @@ void ElementSelector::toString(char* buffer) {
   }
 }
 
+ElementPath::ElementPath(ElementSelector* selectors, int capacity, char* keys, int keyStorageSize) {
+  this->selectors = selectors;
+  this->capacity = capacity < 255 ? capacity : 255;
+  this->keys = keys;
+  this->keyStorageSize = keyStorageSize < 65535 ? keyStorageSize : 65535;
+}
+
 ElementSelector* ElementPath::get(int index) {
   if (index >= count
       || (index < 0 && (index += count - 1) < 0))
@@ -116,12 +112,52 @@ ElementSelector* ElementPath::getParent() {
 
 void ElementPath::pop() {
   if(count > 0) {
+    // the popped level's key was the last one in the arena
+    keyStorageUsed = current->key - keys;
     current = --count > 0 ? &selectors[count - 1] : NULL;
   }
 }
 
-void ElementPath::push() {
-  (current = &selectors[count++])->reset();
+bool ElementPath::push() {
+  if (count >= capacity || keyStorageUsed >= keyStorageSize) {
+    return false;
+  }
+  current = &selectors[count];
+  current->key = &keys[keyStorageUsed];
+  current->reset();
+  keyStorageUsed++;
+  count++;
+  return true;
+}
+
+void ElementPath::reset() {
+  count = 0;
+  current = NULL;
+  keyStorageUsed = 0;
+}
+
+bool ElementPath::setKey(const char* key) {
+  return setKey(key, key != nullptr ? strlen(key) : 0);
+}
+
+bool ElementPath::setKey(const char* key, size_t length) {
+  // the current level's key is the last one in the arena, so it can grow
+  size_t start = current->key - keys;
+  size_t available = keyStorageSize - start - 1;
+  if (available > ELEMENT_PATH_KEY_MAX) {
+    available = ELEMENT_PATH_KEY_MAX;
+  }
+  bool complete = length <= available;
+  if (!complete) {
+    length = available;
+  }
+  if (length > 0) {
+    memcpy(current->key, key, length);
+  }
+  current->key[length] = '\0';
+  current->index = -1;
+  keyStorageUsed = start + length + 1;
+  return complete;
 }
 
 void ElementPath::toString(char* buffer) {
@@ -25,14 +25,20 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <Arduino.h>
+
 #ifndef JSON_PARSER_PATH_MAX_DEPTH
 #define JSON_PARSER_PATH_MAX_DEPTH 20
 #endif
 
+// average key length: keys share JSON_PARSER_PATH_MAX_DEPTH times as many chars
 #ifndef JSON_PARSER_KEY_MAX_LENGTH  
 #define JSON_PARSER_KEY_MAX_LENGTH 20
 #endif
 
+// longest key a path keeps, in chars
+#define ELEMENT_PATH_KEY_MAX  255
+
 /*
   Unified element selector.
   Represents the handle associated to an element within either
@@ -40,11 +46,14 @@ SOFTWARE.
 */
 class ElementSelector {
   friend class ElementPath;
-  friend class JsonStreamingParser;
+  friend class JsonStreamingParserBase;
+  friend class BinaryStreamingParserBase;
+  friend class JsonEventReplayer;
 
   private: 
     int index;
-    char key[JSON_PARSER_KEY_MAX_LENGTH];
+    // points into the key storage of the owning ElementPath
+    char* key;
 
   public:
     int getIndex();
@@ -64,8 +73,6 @@ class ElementSelector {
     
     void set(int index);
     
-    void set(char* key);
-    
     /*
       Advances to next index.
     */
@@ -76,22 +83,49 @@ class ElementSelector {
   Hierarchical path to currently parsed element.
   It eases element filtering, keeping track of the current node
   position.  
+
+  Selectors and keys live in storage owned by the parser (see
+  StaticJsonStreamingParser), so copies of a path are shallow: they are
+  cheap, but only valid during the event they were passed to.
+
+  Keys are stacked back to back in one arena as levels are pushed, so a
+  long key only costs what it uses: each level takes its key length
+  plus one char. Depth and key length are limited to 255.
 */
 class ElementPath {
-  friend class JsonStreamingParser;
+  friend class JsonStreamingParserBase;
+  friend class BinaryStreamingParserBase;
+  friend class JsonEventReplayer;
 
   private:
-    int count = 0;
-    ElementSelector* current;
-    ElementSelector selectors[JSON_PARSER_PATH_MAX_DEPTH];
+    ElementSelector* current = NULL;
+    ElementSelector* selectors;
+    // key arena shared by all levels: the keys packed one after another,
+    // each NUL-terminated, keyStorageSize bytes in total
+    char* keys;
+    uint16_t keyStorageSize;
+    uint16_t keyStorageUsed = 0;
+    uint8_t count = 0;
+    uint8_t capacity;
 
   public:
+    /*
+      Builds a path over caller-provided storage: capacity selectors and
+      a keyStorageSize chars arena for their keys.
+    */
+    ElementPath(ElementSelector* selectors, int capacity, char* keys, int keyStorageSize);
+
     /*
       Gets the element selector at the given level.
     */
     ElementSelector* get(int index);
     
     int getCount();
+
+    /*
+      Maximum depth this path can track.
+    */
+    int getCapacity() { return capacity; }
     
     /*
       Gets current element selector.
@@ -141,7 +175,18 @@ class ElementPath {
 
     void pop();
     
-    void push();
+    bool push();
+
+    void reset();
+
+    /*
+      Sets the current element's key. Returns false if it had to be
+      truncated, to ELEMENT_PATH_KEY_MAX chars or to what is left of the
+      arena.
+    */
+    bool setKey(const char* key);
+
+    bool setKey(const char* key, size_t length);
 };
 
 #endif // ELEMENT_PATH_H
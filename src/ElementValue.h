@@ -2,6 +2,7 @@
 #define ELEMENT_VALUE_H
 
 #include <Arduino.h>
+#include "JsonDigits.h"
 
 union Variant {
   bool boolValue;
@@ -9,26 +10,62 @@ union Variant {
   const char* stringValue;
 };
 
+/*
+  Value of the current element. Numbers from the JSON parser are not
+  converted up front: the value carries the number text and whether it
+  is an integer, and getInt()/getFloat()/getDouble() convert it on first
+  use, caching the result. Like strings, that text lives in the parser's
+  buffer and is only valid during the handler callback.
+*/
 struct ElementValue {
   private:
-    static const int Type_Null = 0;
-    static const int Type_Int = 1;
-    static const int Type_Float = 2;
-    static const int Type_String = 3;
-    static const int Type_Bool = 4;
+    static const uint8_t Type_Null = 0;
+    static const uint8_t Type_Int = 1;
+    static const uint8_t Type_Float = 2;
+    static const uint8_t Type_String = 3;
+    static const uint8_t Type_Bool = 4;
 
+    // which member of number holds a value
+    static const uint8_t Number_None = 0;
+    static const uint8_t Number_Int = 1;
+    static const uint8_t Number_Float = 2;
+    static const uint8_t Number_Double = 3;
+
+    // strings, and number text
     Variant data;
-    int type;
+    union {
+      long intValue;
+      float floatValue;
+      double doubleValue;
+      // strings: their text in the parsed source
+      const char* source;
+    } number;
+    // length of the number or string text, 0 for values given without it
+    uint16_t numberLength;
+    uint8_t type;
+    uint8_t numberCached;
 
   public:
     ElementValue with(float value) {
-      data.numValue = value;
+      number.floatValue = value;
+      numberCached = Number_Float;
+      numberLength = 0;
+      type = Type_Float;
+      return *this;
+    }
+
+    ElementValue with(double value) {
+      number.doubleValue = value;
+      numberCached = Number_Double;
+      numberLength = 0;
       type = Type_Float;
       return *this;
     }
 
     ElementValue with(long value) {
-      data.numValue = value;
+      number.intValue = value;
+      numberCached = Number_Int;
+      numberLength = 0;
       type = Type_Int;
       return *this;
     }
@@ -41,6 +78,20 @@ struct ElementValue {
 
     ElementValue with(const char* value) {
       data.stringValue = value;
+      number.source = nullptr;
+      numberLength = 0;
+      type = Type_String;
+      return *this;
+    }
+
+    /*
+      String of known length, and where its text lives in the parsed
+      source (nullptr if unknown or if escapes changed it).
+    */
+    ElementValue withString(const char* value, size_t length, const char* source) {
+      data.stringValue = value;
+      number.source = source;
+      numberLength = length <= 0xFFFF ? length : 0;
       type = Type_String;
       return *this;
     }
@@ -49,6 +100,17 @@ struct ElementValue {
       type = Type_Null;
       return *this;
     }
+
+    /*
+      Number given as its (NUL-terminated) JSON text, converted lazily.
+    */
+    ElementValue withNumber(const char* text, size_t length, bool integer) {
+      data.stringValue = text;
+      numberLength = length > 0 ? length : 1;
+      numberCached = Number_None;
+      type = integer ? Type_Int : Type_Float;
+      return *this;
+    }
     
     bool getBool() {
       return data.boolValue;
@@ -58,12 +120,136 @@ struct ElementValue {
       return data.stringValue;
     }
 
-    float getFloat() {
-      return data.numValue;
+    size_t getStringLength() {
+      if (!isString()) {
+        return 0;
+      }
+      return numberLength > 0 ? numberLength : strlen(data.stringValue);
+    }
+
+    /*
+      The string's text in the source it was parsed from, if that source
+      was given (e.g. the flash of a JsonFlashReader) and the string had no
+      escapes: getStringLength() chars, not NUL-terminated, valid as long
+      as the source is, e.g. for keeping a PROGMEM pointer instead of a
+      RAM copy. nullptr otherwise.
+    */
+    const char* getStringSource() {
+      return isString() ? number.source : nullptr;
     }
 
     long getInt() {
-      return (long)data.numValue;
+      if (numberCached == Number_Int) {
+        return number.intValue;
+      }
+      long value;
+      if (numberCached == Number_Float) {
+        value = (long) number.floatValue;
+      } else if (numberCached == Number_Double) {
+        value = (long) number.doubleValue;
+      } else {
+        value = type == Type_Int ? jsonParseInteger(data.stringValue, numberLength)
+                                 : (long) jsonParseDouble(data.stringValue);
+      }
+      if (numberLength > 0) {
+        number.intValue = value;
+        numberCached = Number_Int;
+      }
+      return value;
+    }
+
+    float getFloat() {
+      if (numberCached == Number_Float) {
+        return number.floatValue;
+      }
+      float value;
+      if (numberCached == Number_Int) {
+        value = (float) number.intValue;
+      } else if (numberCached == Number_Double) {
+        value = (float) number.doubleValue;
+      } else {
+        value = jsonParseFloat(data.stringValue);
+      }
+      if (numberLength > 0) {
+        number.floatValue = value;
+        numberCached = Number_Float;
+      }
+      return value;
+    }
+
+    double getDouble() {
+      if (numberCached == Number_Double) {
+        return number.doubleValue;
+      }
+      double value;
+      if (numberCached == Number_Int) {
+        value = (double) number.intValue;
+      } else if (numberCached == Number_Float && numberLength == 0) {
+        value = (double) number.floatValue;
+      } else {
+        // from the text if there is one, rather than the rounded float
+        value = jsonParseDouble(data.stringValue);
+      }
+      if (numberLength > 0) {
+        number.doubleValue = value;
+        numberCached = Number_Double;
+      }
+      return value;
+    }
+
+    /*
+      Exact decimal value of a number: mantissa * 10^exponent, computed
+      from its text with integer arithmetic only (see jsonParseDecimal),
+      so no soft-float code runs on FPU-less cores. False for other
+      values and for floats given without text.
+    */
+    bool getDecimal(int64_t* mantissa, int* exponent) {
+      if (numberLength > 0 && (isInt() || isFloat())) {
+        jsonParseDecimal(data.stringValue, numberLength, mantissa, exponent);
+        return true;
+      }
+      if (isInt()) {
+        *mantissa = getInt();
+        *exponent = 0;
+        return true;
+      }
+      return false;
+    }
+
+    /*
+      The number in units of 10^-scale, rounded half away from zero, e.g.
+      getFixed(2) is 1250 for 12.5 (cents from a price). Integer-only for
+      parsed numbers; 0 for values that are not numbers.
+    */
+    int64_t getFixed(int scale) {
+      int64_t mantissa;
+      int exponent;
+      if (getDecimal(&mantissa, &exponent)) {
+        return jsonScaleDecimal(mantissa, exponent, scale);
+      }
+      if (!isFloat()) {
+        return 0;
+      }
+      double value = getDouble();
+      for (int i = 0; i < scale; i++) {
+        value *= 10;
+      }
+      for (int i = 0; i > scale; i--) {
+        value /= 10;
+      }
+      return (int64_t) (value < 0 ? value - 0.5 : value + 0.5);
+    }
+
+    /*
+      JSON text of a number from the parser (nullptr otherwise), e.g. to
+      copy it unchanged.
+    */
+    const char* getNumberText() {
+      return (isInt() || isFloat()) && numberLength > 0 ? data.stringValue : nullptr;
+    }
+
+    size_t getNumberLength() {
+      return (isInt() || isFloat()) ? numberLength : 0;
     }
 
     bool isInt() {
@@ -0,0 +1,83 @@
+#include "JsonBinding.h"
+
+void jsonBindLocate(ElementPath& path, bool hasRecords, JsonBindLocation& location) {
+  uint32_t hash = JSON_PATH_HASH_SEED;
+  location.recordIndex = -1;
+  location.nestedFirst = true;
+
+  int count = path.getCount();
+  for (int level = 0; level < count; level++) {
+    ElementSelector* selector = path.get(level);
+    if (!selector->isObject()) {
+      if (hasRecords && location.recordIndex < 0) {
+        location.recordIndex = selector->getIndex();
+      } else if (selector->getIndex() > 0) {
+        location.nestedFirst = false;
+      }
+    }
+    hash = jsonPathHashAppend(hash, selector, level);
+  }
+  location.pathHash = hash;
+}
+
+static void storeInteger(uint8_t* target, uint16_t size, long long value) {
+  switch (size) {
+    case 1: { int8_t v = (int8_t) value; memcpy(target, &v, 1); } break;
+    case 2: { int16_t v = (int16_t) value; memcpy(target, &v, 2); } break;
+    case 4: { int32_t v = (int32_t) value; memcpy(target, &v, 4); } break;
+    case 8: { int64_t v = (int64_t) value; memcpy(target, &v, 8); } break;
+  }
+}
+
+bool jsonBindStore(void* record, const JsonFieldBinding& field, ElementValue& value) {
+  uint8_t* target = (uint8_t*) record + field.offset;
+
+  switch (field.kind) {
+    case JSON_FIELD_SIGNED:
+    case JSON_FIELD_UNSIGNED:
+      if (value.isInt()) {
+        storeInteger(target, field.size, value.getInt());
+      } else if (value.isFloat()) {
+        storeInteger(target, field.size, (long long) value.getFloat());
+      } else if (value.isBool()) {
+        storeInteger(target, field.size, value.getBool() ? 1 : 0);
+      } else {
+        return false;
+      }
+      return true;
+
+    case JSON_FIELD_FLOAT: {
+      if (!value.isInt() && !value.isFloat()) {
+        return false;
+      }
+      if (field.size == sizeof(float)) {
+        float number = value.getFloat();
+        memcpy(target, &number, sizeof(float));
+      } else {
+        // converted from the text at double precision, not via float
+        double number = value.getDouble();
+        memcpy(target, &number, sizeof(double));
+      }
+      return true;
+    }
+
+    case JSON_FIELD_BOOL:
+      if (value.isBool()) {
+        *(bool*) target = value.getBool();
+      } else if (value.isInt()) {
+        *(bool*) target = value.getInt() != 0;
+      } else {
+        return false;
+      }
+      return true;
+
+    case JSON_FIELD_STRING:
+      if (!value.isString() || field.size == 0) {
+        return false;
+      }
+      strncpy((char*) target, value.getString(), field.size - 1);
+      ((char*) target)[field.size - 1] = '\0';
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,231 @@
+#ifndef JSON_BINDING_H
+#define JSON_BINDING_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include "JsonHandler.h"
+#include "JsonPathHash.h"
+
+/*
+  Declarative JSON -> struct binding.
+
+  Instead of hand-writing a value() state machine, declare which normalized
+  path (see JsonPathHash.h) goes into which struct member:
+
+    struct Forecast { time_t datetime; int temp; char summary[16]; };
+
+    static const JsonFieldBinding forecastFields[] = {
+      JSON_BIND(Forecast, datetime, "list[].dt"),
+      JSON_BIND(Forecast, temp,     "list[].main.temp"),
+      JSON_BIND(Forecast, summary,  "list[].weather[].main"),
+    };
+
+    Forecast forecasts[8];
+    JsonStructBinder<Forecast> binder(forecastFields, forecasts, 8);
+    parser.setHandler(&binder);
+
+  Paths are hashed, and member offsets/types resolved, at compile time: at
+  runtime each value costs one hash of the current path and a scan of the
+  (small) table, with no string compares nor toString() calls.
+
+  With a capacity greater than 1, the outermost array of the document
+  selects the record (list[3].* goes into forecasts[3]); records beyond the
+  capacity are dropped. Arrays nested deeper follow each field's policy.
+*/
+
+enum JsonFieldKind {
+  JSON_FIELD_SIGNED,
+  JSON_FIELD_UNSIGNED,
+  JSON_FIELD_FLOAT,
+  JSON_FIELD_BOOL,
+  JSON_FIELD_STRING
+};
+
+/*
+  What to do when a bound path crosses an array below the record level
+  (e.g. "weather[]" in "list[].weather[].main").
+*/
+enum JsonArrayPolicy {
+  JSON_BIND_FIRST,    // keep the first item's value only
+  JSON_BIND_LAST      // every item overwrites, the last one wins
+};
+
+struct JsonFieldBinding {
+  uint32_t pathHash;
+  uint16_t offset;
+  uint16_t size;
+  uint8_t kind;
+  uint8_t policy;
+};
+
+template <typename M> struct JsonFieldTraits;
+
+#define JSON_FIELD_TRAITS(type, fieldKind) \
+  template <> struct JsonFieldTraits<type> { static const uint8_t kind = fieldKind; };
+
+JSON_FIELD_TRAITS(bool, JSON_FIELD_BOOL)
+JSON_FIELD_TRAITS(char, JSON_FIELD_SIGNED)
+JSON_FIELD_TRAITS(signed char, JSON_FIELD_SIGNED)
+JSON_FIELD_TRAITS(unsigned char, JSON_FIELD_UNSIGNED)
+JSON_FIELD_TRAITS(short, JSON_FIELD_SIGNED)
+JSON_FIELD_TRAITS(unsigned short, JSON_FIELD_UNSIGNED)
+JSON_FIELD_TRAITS(int, JSON_FIELD_SIGNED)
+JSON_FIELD_TRAITS(unsigned int, JSON_FIELD_UNSIGNED)
+JSON_FIELD_TRAITS(long, JSON_FIELD_SIGNED)
+JSON_FIELD_TRAITS(unsigned long, JSON_FIELD_UNSIGNED)
+JSON_FIELD_TRAITS(long long, JSON_FIELD_SIGNED)
+JSON_FIELD_TRAITS(unsigned long long, JSON_FIELD_UNSIGNED)
+JSON_FIELD_TRAITS(float, JSON_FIELD_FLOAT)
+JSON_FIELD_TRAITS(double, JSON_FIELD_FLOAT)
+
+template <size_t N> struct JsonFieldTraits<char[N]> { static const uint8_t kind = JSON_FIELD_STRING; };
+
+#define JSON_BIND_POLICY(Struct, member, path, arrayPolicy) \
+  { jsonPathHash(path), (uint16_t) offsetof(Struct, member), (uint16_t) sizeof(((Struct*) 0)->member), \
+    JsonFieldTraits<decltype(((Struct*) 0)->member)>::kind, (uint8_t) (arrayPolicy) }
+
+#define JSON_BIND(Struct, member, path) JSON_BIND_POLICY(Struct, member, path, JSON_BIND_FIRST)
+
+/*
+  Converts value to the field's type and stores it at record + field.offset.
+  Returns false (storing nothing) on a type mismatch, e.g. an object into a
+  number or a number into a string member.
+*/
+bool jsonBindStore(void* record, const JsonFieldBinding& field, ElementValue& value);
+
+/*
+  Where the current path lands with respect to records and nested arrays.
+*/
+struct JsonBindLocation {
+  uint32_t pathHash;
+  int recordIndex;      // index within the outermost array, -1 if none
+  bool nestedFirst;     // true if every array below the record level is at its first item
+};
+
+void jsonBindLocate(ElementPath& path, bool hasRecords, JsonBindLocation& location);
+
+/*
+  Called when a record (an item of the outermost array) is complete.
+*/
+template <typename T>
+struct JsonRecordCallback {
+  typedef void (*Type)(T& record, int index, void* context);
+};
+
+template <typename T>
+class JsonStructBinder: public JsonHandler {
+  private:
+    const JsonFieldBinding* fields;
+    int fieldCount;
+
+    T* records;
+    int capacity;
+    int count = 0;
+
+    typename JsonRecordCallback<T>::Type onRecord = nullptr;
+    void* recordContext = nullptr;
+
+    bool hasRecords() const { return capacity > 1 || onRecord != nullptr; }
+
+    // Streaming mode (callback set) reuses the first slot for every record.
+    T* slot(int recordIndex) {
+      if (onRecord != nullptr) {
+        return &records[0];
+      }
+      if (recordIndex < 0) {
+        recordIndex = 0;
+      }
+      return recordIndex < capacity ? &records[recordIndex] : nullptr;
+    }
+
+    bool isRecord(ElementPath& path) {
+      // The container's own selector is the current one: it is a record if
+      // it is an item of the outermost array.
+      int level = path.getCount() - 1;
+      if (level < 0 || path.get(level)->isObject()) {
+        return false;
+      }
+      for (int i = 0; i < level; i++) {
+        if (!path.get(i)->isObject()) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+  public:
+    template <size_t N>
+    JsonStructBinder(const JsonFieldBinding (&fields)[N], T* records, int capacity = 1) {
+      this->fields = fields;
+      this->fieldCount = N;
+      this->records = records;
+      this->capacity = capacity;
+    }
+
+    /*
+      Delivers each record as soon as it is complete, so that unbounded
+      arrays can be consumed with a single slot.
+    */
+    void setRecordCallback(typename JsonRecordCallback<T>::Type callback, void* context = nullptr) {
+      onRecord = callback;
+      recordContext = context;
+    }
+
+    /*
+      Number of records filled so far (records seen, in streaming mode).
+    */
+    int getCount() const { return count; }
+
+    virtual void startDocument() {
+      count = 0;
+    }
+
+    virtual void endDocument() { }
+
+    virtual void startObject(ElementPath path) {
+      if (onRecord != nullptr && isRecord(path)) {
+        memset((void*) &records[0], 0, sizeof(T));
+      }
+    }
+
+    virtual void endObject(ElementPath path) {
+      if (hasRecords() && isRecord(path)) {
+        int index = path.getIndex();
+        if (onRecord != nullptr) {
+          onRecord(records[0], index, recordContext);
+          count = index + 1;
+        } else if (index < capacity && index >= count) {
+          count = index + 1;
+        }
+      }
+    }
+
+    virtual void startArray(ElementPath /* path */) { }
+
+    virtual void endArray(ElementPath /* path */) { }
+
+    virtual void value(ElementPath path, ElementValue value) {
+      JsonBindLocation location;
+      jsonBindLocate(path, hasRecords(), location);
+      for (int i = 0; i < fieldCount; i++) {
+        const JsonFieldBinding& field = fields[i];
+        if (field.pathHash != location.pathHash) {
+          continue;
+        }
+        if (field.policy == JSON_BIND_FIRST && !location.nestedFirst) {
+          continue;
+        }
+        T* record = slot(location.recordIndex);
+        if (record == nullptr) {
+          continue;
+        }
+        if (jsonBindStore(record, field, value) && !hasRecords()) {
+          count = 1;
+        }
+      }
+    }
+
+    virtual void whitespace(char /* c */) { }
+};
+
+#endif // JSON_BINDING_H
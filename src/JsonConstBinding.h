@@ -0,0 +1,480 @@
+#ifndef JSON_CONST_BINDING_H
+#define JSON_CONST_BINDING_H
+
+#include <Arduino.h>
+#include "JsonBinding.h"
+
+/*
+  Compile-time JSON -> struct binding (C++20).
+
+  Constant JSON embedded in the firmware (device tables, calibration) can
+  be parsed by the compiler instead of at every boot. The result is a
+  constant table, placed in flash along with the rest of the read-only
+  data, and nothing is left to do at runtime:
+
+    struct Sensor { int id; float gain; char name[12]; };
+
+    constexpr auto sensors = jsonConstParse<Sensor, 4>(R"([
+        { "id": 1, "gain": 1.25, "name": "left" },
+        { "id": 2, "gain": 0.5,  "name": "right" }
+      ])",
+      jsonConstBind(&Sensor::id,   "[].id"),
+      jsonConstBind(&Sensor::gain, "[].gain"),
+      jsonConstBind(&Sensor::name, "[].name"));
+
+    static_assert(sensors.size() == 2);
+
+  Paths, record selection (with a capacity greater than 1, the outermost
+  array selects the record) and array policies are those of
+  JsonStructBinder, so the same table can be bound at runtime from a
+  file. Unlike JsonStructBinder, anything that does not fit is a compile
+  error naming the problem: malformed JSON, a value whose path has no
+  binding, a type mismatch, a string longer than its member, more
+  records than the capacity.
+
+  Needs C++20 (e.g. build_flags = -std=gnu++2a, ESP32 core 3 and ARM
+  toolchains); on AVR, where read-only data lives in RAM, use it for
+  tables small enough to be copied there anyway.
+*/
+
+#if __cplusplus >= 202002L
+
+#include <type_traits>
+
+#ifndef JSON_CONST_MAX_DEPTH
+#define JSON_CONST_MAX_DEPTH  16
+#endif
+
+/*
+  Not constexpr: reaching it during constant evaluation is what makes the
+  compiler report the message.
+*/
+inline void jsonConstError(const char* /* message */) { }
+
+template <typename T, typename M>
+struct JsonConstField {
+  M T::* member;
+  uint32_t pathHash;
+  uint8_t policy;
+};
+
+template <typename T, typename M>
+consteval JsonConstField<T, M> jsonConstBind(M T::* member, const char* path, JsonArrayPolicy policy = JSON_BIND_FIRST) {
+  return { member, jsonPathHash(path), (uint8_t) policy };
+}
+
+/*
+  Parsed records: iterable, indexable and constexpr.
+*/
+template <typename T, size_t N>
+struct JsonConstRecords {
+  T records[N] = {};
+  size_t count = 0;
+
+  constexpr size_t size() const { return count; }
+  constexpr const T& operator[](size_t index) const { return records[index]; }
+  constexpr const T* begin() const { return records; }
+  constexpr const T* end() const { return records + count; }
+};
+
+enum JsonConstKind : uint8_t {
+  JSON_CONST_STRING,
+  JSON_CONST_INT,
+  JSON_CONST_FLOAT,
+  JSON_CONST_BOOL,
+  JSON_CONST_NULL
+};
+
+/*
+  Scalar value; strings are a range of the source, still escaped.
+*/
+struct JsonConstValue {
+  JsonConstKind kind = JSON_CONST_NULL;
+  long long integer = 0;
+  double number = 0;
+  const char* begin = nullptr;
+  const char* end = nullptr;
+};
+
+/*
+  Recursive descent over the JSON grammar the streaming parser accepts:
+  a document is an object or an array, numbers may not have leading
+  zeros, strings may hold any escape, \u escapes (and surrogate pairs)
+  become UTF-8.
+*/
+class JsonConstReader {
+  private:
+    const char* p;
+
+  public:
+    constexpr JsonConstReader(const char* json) : p(json) { }
+
+    constexpr bool atEnd() const { return *p == '\0'; }
+
+    constexpr void skipWhitespace() {
+      while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+        p++;
+      }
+    }
+
+    constexpr void expect(char c) {
+      skipWhitespace();
+      if (*p != c) {
+        // one literal per call, for the compiler to quote
+        if (c == ':') {
+          jsonConstError("JSON: expected ':'");
+        } else if (c == '"') {
+          jsonConstError("JSON: expected a string");
+        } else if (c == '}') {
+          jsonConstError("JSON: expected ',' or '}'");
+        } else {
+          jsonConstError("JSON: expected ',' or ']'");
+        }
+      }
+      p++;
+    }
+
+    constexpr bool consume(char c) {
+      skipWhitespace();
+      if (*p == c) {
+        p++;
+        return true;
+      }
+      return false;
+    }
+
+    /*
+      Skips a string, p at its opening quote; returns its (escaped) range.
+    */
+    constexpr void string(const char*& begin, const char*& end) {
+      expect('"');
+      begin = p;
+      while (*p != '"') {
+        if (*p == '\0' || (unsigned char) *p < 0x20) {
+          jsonConstError("JSON: unterminated string");
+        }
+        if (*p == '\\') {
+          p++;
+          if (*p == 'u') {
+            for (int i = 1; i <= 4; i++) {
+              char h = p[i];
+              if (!((h >= '0' && h <= '9') || (h >= 'a' && h <= 'f') || (h >= 'A' && h <= 'F'))) {
+                jsonConstError("JSON: invalid \\u escape");
+              }
+            }
+            p += 4;
+          } else if (*p != '"' && *p != '\\' && *p != '/' && *p != 'b' && *p != 'f' && *p != 'n' && *p != 'r' && *p != 't') {
+            jsonConstError("JSON: invalid escape");
+          }
+        }
+        p++;
+      }
+      end = p++;
+    }
+
+    constexpr void literal(const char* word) {
+      for (; *word; word++, p++) {
+        if (*p != *word) {
+          jsonConstError("JSON: invalid literal");
+        }
+      }
+    }
+
+    constexpr JsonConstValue scalar() {
+      JsonConstValue value;
+      skipWhitespace();
+      char c = *p;
+      if (c == '"') {
+        value.kind = JSON_CONST_STRING;
+        string(value.begin, value.end);
+      } else if (c == 't' || c == 'f') {
+        value.kind = JSON_CONST_BOOL;
+        value.integer = c == 't';
+        literal(c == 't' ? "true" : "false");
+      } else if (c == 'n') {
+        literal("null");
+      } else if (c == '-' || (c >= '0' && c <= '9')) {
+        number(value);
+      } else {
+        jsonConstError("JSON: unexpected character");
+      }
+      return value;
+    }
+
+    constexpr void number(JsonConstValue& value) {
+      bool negative = *p == '-';
+      if (negative) {
+        p++;
+      }
+      if (*p < '0' || *p > '9') {
+        jsonConstError("JSON: invalid number");
+      }
+      if (*p == '0' && p[1] >= '0' && p[1] <= '9') {
+        jsonConstError("JSON: leading zeros in number");
+      }
+      unsigned long long mantissa = 0;
+      int exponent = 0;
+      bool integer = true;
+      for (; *p >= '0' && *p <= '9'; p++) {
+        if (mantissa < 1000000000000000000ULL) {
+          mantissa = mantissa * 10 + (*p - '0');
+        } else {
+          exponent++;
+          integer = false;
+        }
+      }
+      if (*p == '.') {
+        integer = false;
+        p++;
+        if (*p < '0' || *p > '9') {
+          jsonConstError("JSON: invalid number");
+        }
+        for (; *p >= '0' && *p <= '9'; p++) {
+          if (mantissa < 1000000000000000000ULL) {
+            mantissa = mantissa * 10 + (*p - '0');
+            exponent--;
+          }
+        }
+      }
+      if (*p == 'e' || *p == 'E') {
+        integer = false;
+        p++;
+        bool negativeExponent = *p == '-';
+        if (*p == '-' || *p == '+') {
+          p++;
+        }
+        if (*p < '0' || *p > '9') {
+          jsonConstError("JSON: invalid number");
+        }
+        int digits = 0;
+        for (; *p >= '0' && *p <= '9'; p++) {
+          if (digits < 10000) {
+            digits = digits * 10 + (*p - '0');
+          }
+        }
+        exponent += negativeExponent ? -digits : digits;
+      }
+
+      double scaled = (double) mantissa;
+      for (; exponent > 0; exponent--) {
+        scaled *= 10;
+      }
+      for (; exponent < 0; exponent++) {
+        scaled /= 10;
+      }
+      if (integer && mantissa > (negative ? 9223372036854775808ULL : 9223372036854775807ULL)) {
+        jsonConstError("JSON: integer out of range");
+      }
+      value.kind = integer ? JSON_CONST_INT : JSON_CONST_FLOAT;
+      // -2^63 has no positive counterpart: negated in unsigned arithmetic
+      value.integer = negative ? (long long) (0ULL - mantissa) : (long long) mantissa;
+      value.number = negative ? -scaled : scaled;
+    }
+};
+
+/*
+  Decodes the escaped range of a string, handing each UTF-8 byte to out.
+*/
+template <typename Out>
+constexpr void jsonConstUnescape(const char* p, const char* end, Out out) {
+  while (p < end) {
+    char c = *p++;
+    if (c != '\\') {
+      out(c);
+      continue;
+    }
+    c = *p++;
+    if (c != 'u') {
+      out(c == 'b' ? '\b' : c == 'f' ? '\f' : c == 'n' ? '\n' : c == 'r' ? '\r' : c == 't' ? '\t' : c);
+      continue;
+    }
+    uint32_t code = 0;
+    for (int i = 0; i < 4; i++, p++) {
+      code = code * 16 + (*p <= '9' ? *p - '0' : (*p | 0x20) - 'a' + 10);
+    }
+    if (code >= 0xD800 && code < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+      uint32_t low = 0;
+      for (int i = 2; i < 6; i++) {
+        low = low * 16 + (p[i] <= '9' ? p[i] - '0' : (p[i] | 0x20) - 'a' + 10);
+      }
+      if (low >= 0xDC00 && low < 0xE000) {
+        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        p += 6;
+      }
+    }
+    if (code < 0x80) {
+      out((char) code);
+    } else if (code < 0x800) {
+      out((char) (0xC0 | (code >> 6)));
+      out((char) (0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+      out((char) (0xE0 | (code >> 12)));
+      out((char) (0x80 | ((code >> 6) & 0x3F)));
+      out((char) (0x80 | (code & 0x3F)));
+    } else {
+      out((char) (0xF0 | (code >> 18)));
+      out((char) (0x80 | ((code >> 12) & 0x3F)));
+      out((char) (0x80 | ((code >> 6) & 0x3F)));
+      out((char) (0x80 | (code & 0x3F)));
+    }
+  }
+}
+
+template <typename M>
+constexpr void jsonConstStore(M& target, const JsonConstValue& value) {
+  if constexpr (std::is_same_v<M, bool>) {
+    if (value.kind != JSON_CONST_BOOL && value.kind != JSON_CONST_INT) {
+      jsonConstError("JSON binding: expected a bool");
+    }
+    target = value.integer != 0;
+  } else if constexpr (std::is_integral_v<M>) {
+    if (value.kind == JSON_CONST_INT || value.kind == JSON_CONST_BOOL) {
+      target = (M) value.integer;
+      if ((long long) target != value.integer) {
+        jsonConstError("JSON binding: integer out of range");
+      }
+    } else if (value.kind == JSON_CONST_FLOAT) {
+      target = (M) value.number;
+    } else {
+      jsonConstError("JSON binding: expected a number");
+    }
+  } else if constexpr (std::is_floating_point_v<M>) {
+    if (value.kind == JSON_CONST_INT) {
+      target = (M) value.integer;
+    } else if (value.kind == JSON_CONST_FLOAT) {
+      target = (M) value.number;
+    } else {
+      jsonConstError("JSON binding: expected a number");
+    }
+  } else if constexpr (std::is_array_v<M> && std::is_same_v<std::remove_extent_t<M>, char>) {
+    if (value.kind != JSON_CONST_STRING) {
+      jsonConstError("JSON binding: expected a string");
+    }
+    size_t length = 0;
+    jsonConstUnescape(value.begin, value.end, [&](char c) {
+      if (length + 1 >= sizeof(M)) {
+        jsonConstError("JSON binding: string too long for its member");
+      }
+      target[length++] = c;
+    });
+    target[length] = '\0';
+  } else {
+    static_assert(sizeof(M) == 0, "jsonConstBind: members must be bool, integers, floats or char arrays");
+  }
+}
+
+template <typename T, size_t N>
+class JsonConstBinder {
+  private:
+    JsonConstReader reader;
+    JsonConstRecords<T, N> result;
+
+    struct Location {
+      uint32_t hash;
+      int recordIndex;
+      bool nestedFirst;
+    };
+
+    template <typename Field>
+    constexpr bool bind(const Field& field, const Location& location, const JsonConstValue& value) {
+      if (field.pathHash != location.hash) {
+        return false;
+      }
+      if (field.policy == JSON_BIND_FIRST && !location.nestedFirst) {
+        return true;
+      }
+      size_t index = location.recordIndex < 0 ? 0 : location.recordIndex;
+      if (index >= N) {
+        jsonConstError("JSON binding: more records than the capacity");
+      }
+      jsonConstStore(result.records[index].*field.member, value);
+      if (index + 1 > result.count) {
+        result.count = index + 1;
+      }
+      return true;
+    }
+
+    template <typename... Bound>
+    constexpr void value(Location location, const Bound&... fields) {
+      JsonConstValue value = reader.scalar();
+      if (value.kind == JSON_CONST_NULL) {
+        // members keep their default
+        return;
+      }
+      if (!(bind(fields, location, value) | ... | false)) {
+        jsonConstError("JSON binding: value without a binding");
+      }
+    }
+
+    template <typename... Bound>
+    constexpr void element(Location location, int level, const Bound&... fields) {
+      if (level >= JSON_CONST_MAX_DEPTH) {
+        jsonConstError("JSON: too deeply nested");
+      }
+      if (reader.consume('{')) {
+        if (reader.consume('}')) {
+          return;
+        }
+        do {
+          const char* begin = nullptr;
+          const char* end = nullptr;
+          reader.string(begin, end);
+          Location member = location;
+          if (level > 0) {
+            member.hash = jsonPathHashStep(member.hash, '.');
+          }
+          jsonConstUnescape(begin, end, [&](char c) { member.hash = jsonPathHashStep(member.hash, c); });
+          reader.expect(':');
+          element(member, level + 1, fields...);
+        } while (reader.consume(','));
+        reader.expect('}');
+      } else if (reader.consume('[')) {
+        if (reader.consume(']')) {
+          return;
+        }
+        int index = 0;
+        do {
+          Location item = location;
+          item.hash = jsonPathHashStep(jsonPathHashStep(item.hash, '['), ']');
+          if (N > 1 && item.recordIndex < 0) {
+            item.recordIndex = index;
+          } else if (index > 0) {
+            item.nestedFirst = false;
+          }
+          element(item, level + 1, fields...);
+          index++;
+        } while (reader.consume(','));
+        reader.expect(']');
+      } else if (level == 0) {
+        jsonConstError("JSON: document must start with object or array");
+      } else {
+        value(location, fields...);
+      }
+    }
+
+  public:
+    constexpr JsonConstBinder(const char* json) : reader(json) { }
+
+    template <typename... Bound>
+    constexpr JsonConstRecords<T, N> parse(const Bound&... fields) {
+      element({ JSON_PATH_HASH_SEED, -1, true }, 0, fields...);
+      reader.skipWhitespace();
+      if (!reader.atEnd()) {
+        jsonConstError("JSON: unexpected data after the document");
+      }
+      return result;
+    }
+};
+
+/*
+  Parses json into up to N records of T at compile time, storing values
+  as bound by the jsonConstBind() fields.
+*/
+template <typename T, size_t N = 1, typename... Members>
+consteval JsonConstRecords<T, N> jsonConstParse(const char* json, JsonConstField<T, Members>... fields) {
+  return JsonConstBinder<T, N>(json).parse(fields...);
+}
+
+#endif // __cplusplus >= 202002L
+
+#endif // JSON_CONST_BINDING_H
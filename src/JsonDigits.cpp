@@ -0,0 +1,160 @@
+#include "JsonDigits.h"
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+long jsonParseInteger(const char* text, size_t length) {
+  const char* end = text + length;
+  bool negative = *text == '-';
+  if (negative) {
+    text++;
+  }
+  uint64_t magnitude = 0;
+  uint8_t digits = 0;
+#if JSON_PARSER_SWAR
+  uint64_t word;
+  // at most 16 digits this way, so that magnitude cannot overflow
+  while (digits <= 8 && end - text >= 8 && jsonIsEightDigits(word = jsonLoadEightBytes(text))) {
+    magnitude = magnitude * 100000000 + jsonEightDigitsValue(word);
+    text += 8;
+    digits += 8;
+  }
+#else
+  (void) end;
+#endif
+  while (*text >= '0' && *text <= '9' && digits < 19) {
+    magnitude = magnitude * 10 + (*text++ - '0');
+    digits++;
+  }
+  if (*text >= '0' && *text <= '9') {
+    // more than 19 digits
+    return negative ? LONG_MIN : LONG_MAX;
+  }
+  if (negative) {
+    return magnitude > (uint64_t) LONG_MAX + 1 ? LONG_MIN : (long) (0 - magnitude);
+  }
+  return magnitude > (uint64_t) LONG_MAX ? LONG_MAX : (long) magnitude;
+}
+
+// significant digits kept: below 10^18, any int64_t scaling step fits
+#define JSON_DECIMAL_DIGITS_MAX  18
+// beyond this, a value is 0 or out of any range anyway
+#define JSON_DECIMAL_EXPONENT_MAX  9999
+
+static const int64_t powersOf10[] = {
+  1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL, 1000000000LL,
+  10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL, 100000000000000LL,
+  1000000000000000LL, 10000000000000000LL, 100000000000000000LL, 1000000000000000000LL
+};
+
+void jsonParseDecimal(const char* text, size_t length, int64_t* mantissa, int* exponent) {
+  const char* end = text + length;
+  bool negative = text < end && *text == '-';
+  if (negative) {
+    text++;
+  }
+  uint64_t magnitude = 0;
+  // significant digits in magnitude
+  int digits = 0;
+  int scale = 0;
+  bool fraction = false;
+  while (text < end) {
+#if JSON_PARSER_SWAR
+    uint64_t word;
+    if (digits > 0 && digits <= JSON_DECIMAL_DIGITS_MAX - 8 && end - text >= 8
+        && jsonIsEightDigits(word = jsonLoadEightBytes(text))) {
+      magnitude = magnitude * 100000000 + jsonEightDigitsValue(word);
+      digits += 8;
+      if (fraction) {
+        scale -= 8;
+      }
+      text += 8;
+      continue;
+    }
+#endif
+    char c = *text;
+    if (c >= '0' && c <= '9') {
+      if (digits < JSON_DECIMAL_DIGITS_MAX) {
+        magnitude = magnitude * 10 + (c - '0');
+        if (magnitude > 0) {
+          // leading zeros are not significant
+          digits++;
+        }
+        if (fraction) {
+          scale--;
+        }
+      } else if (!fraction) {
+        // dropped integer digit
+        scale++;
+      }
+    } else if (c == '.') {
+      fraction = true;
+    } else {
+      break;
+    }
+    text++;
+  }
+  if (text < end && (*text == 'e' || *text == 'E')) {
+    text++;
+    bool negativeExponent = text < end && *text == '-';
+    if (text < end && (*text == '-' || *text == '+')) {
+      text++;
+    }
+    int value = 0;
+    while (text < end && *text >= '0' && *text <= '9') {
+      if (value < JSON_DECIMAL_EXPONENT_MAX) {
+        value = value * 10 + (*text - '0');
+      }
+      text++;
+    }
+    scale += negativeExponent ? -value : value;
+  }
+  *mantissa = negative ? -(int64_t) magnitude : (int64_t) magnitude;
+  *exponent = magnitude == 0 ? 0 : scale;
+}
+
+int64_t jsonScaleDecimal(int64_t mantissa, int exponent, int scale) {
+  int shift = exponent + scale;
+  if (mantissa == 0 || shift == 0) {
+    return mantissa;
+  }
+  bool negative = mantissa < 0;
+  uint64_t magnitude = negative ? 0 - (uint64_t) mantissa : (uint64_t) mantissa;
+  if (shift > 0) {
+    uint64_t limit = negative ? (uint64_t) INT64_MAX + 1 : (uint64_t) INT64_MAX;
+    while (shift > 0) {
+      int step = shift < JSON_DECIMAL_DIGITS_MAX ? shift : JSON_DECIMAL_DIGITS_MAX;
+      if (magnitude > limit / (uint64_t) powersOf10[step]) {
+        return negative ? INT64_MIN : INT64_MAX;
+      }
+      magnitude *= (uint64_t) powersOf10[step];
+      shift -= step;
+    }
+    if (magnitude > limit) {
+      return negative ? INT64_MIN : INT64_MAX;
+    }
+    return negative ? (int64_t) (0 - magnitude) : (int64_t) magnitude;
+  }
+  if (-shift > JSON_DECIMAL_DIGITS_MAX + 1) {
+    return 0;
+  }
+  // all but the last dropped digit, which decides the rounding
+  if (-shift > 1) {
+    magnitude /= (uint64_t) powersOf10[-shift - 1];
+  }
+  uint64_t rounded = magnitude / 10 + (magnitude % 10 >= 5 ? 1 : 0);
+  return negative ? -(int64_t) rounded : (int64_t) rounded;
+}
+
+float jsonParseFloat(const char* text) {
+#ifdef __AVR__
+  // double is float there
+  return strtod(text, NULL);
+#else
+  return strtof(text, NULL);
+#endif
+}
+
+double jsonParseDouble(const char* text) {
+  return strtod(text, NULL);
+}
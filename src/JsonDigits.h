@@ -0,0 +1,89 @@
+#ifndef JSON_DIGITS_H
+#define JSON_DIGITS_H
+
+#include <Arduino.h>
+
+/*
+  Number text conversion shared by the parser and ElementValue.
+
+  SWAR (SIMD within a register) digit handling works on 8 ASCII digits
+  per 64-bit word. It is only worth it on 32/64-bit little-endian cores;
+  AVR handles 64-bit words a byte at a time. Define JSON_PARSER_SWAR as 0
+  or 1 to override.
+*/
+#ifndef JSON_PARSER_SWAR
+  #if !defined(__AVR__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    #define JSON_PARSER_SWAR 1
+  #else
+    #define JSON_PARSER_SWAR 0
+  #endif
+#endif
+
+#if JSON_PARSER_SWAR
+inline uint64_t jsonLoadEightBytes(const char* text) {
+  uint64_t word;
+  memcpy(&word, text, sizeof(word));
+  return word;
+}
+
+inline bool jsonIsEightDigits(uint64_t word) {
+  return ((word & 0xF0F0F0F0F0F0F0F0ULL)
+          | (((word + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+}
+
+/*
+  True if none of the 8 bytes ends a run of plain string bytes: a quote,
+  a backslash or a control character.
+*/
+inline bool jsonIsEightStringBytes(uint64_t word) {
+  const uint64_t ones = 0x0101010101010101ULL;
+  const uint64_t highs = 0x8080808080808080ULL;
+  uint64_t quote = word ^ (ones * '"');
+  uint64_t backslash = word ^ (ones * '\\');
+  uint64_t del = word ^ (ones * 0x7F);
+  return ((((word - ones * 0x20) & ~word)
+           | ((quote - ones) & ~quote)
+           | ((backslash - ones) & ~backslash)
+           | ((del - ones) & ~del)) & highs) == 0;
+}
+
+/*
+  Value of 8 digits, the first one in the lowest byte: pairs, then
+  quadruples, then both halves are combined with one multiply each.
+*/
+inline uint32_t jsonEightDigitsValue(uint64_t word) {
+  word -= 0x3030303030303030ULL;
+  word = (word * 10) + (word >> 8);
+  word = (((word & 0x000000FF000000FFULL) * 0x000F424000000064ULL)
+          + (((word >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >> 32;
+  return (uint32_t) word;
+}
+#endif
+
+/*
+  Integer value of the optionally signed run of digits starting text (of
+  length chars, NUL-terminated), stopping at the first other char and
+  clamped to the long range like strtol().
+*/
+long jsonParseInteger(const char* text, size_t length);
+
+/*
+  Exact value of the JSON number text (length chars) as mantissa *
+  10^exponent, with integer arithmetic only, e.g. "-12.50" is -1250 and
+  -2. Up to 18 significant digits are kept; further ones are dropped.
+*/
+void jsonParseDecimal(const char* text, size_t length, int64_t* mantissa, int* exponent);
+
+/*
+  mantissa * 10^(exponent + scale), rounded half away from zero and
+  clamped to the int64_t range: the value in units of 10^-scale.
+*/
+int64_t jsonScaleDecimal(int64_t mantissa, int exponent, int scale);
+
+/*
+  Value of a NUL-terminated JSON number.
+*/
+float jsonParseFloat(const char* text);
+double jsonParseDouble(const char* text);
+
+#endif // JSON_DIGITS_H
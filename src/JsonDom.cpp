@@ -0,0 +1,394 @@
+#include "JsonDom.h"
+#include <limits.h>
+
+const JsonDomNode* JsonDomValue::node() const {
+  if (dom == nullptr || index >= dom->nodeCount) {
+    return nullptr;
+  }
+  return &dom->nodes[index];
+}
+
+int JsonDomValue::getType() const {
+  const JsonDomNode* n = node();
+  return n != nullptr ? (int) n->type : (int) JSON_DOM_NULL;
+}
+
+bool JsonDomValue::getBool() const {
+  const JsonDomNode* n = node();
+  return n != nullptr && n->type == JSON_DOM_BOOL && n->data.boolValue;
+}
+
+long JsonDomValue::getInt() const {
+  const JsonDomNode* n = node();
+  if (n == nullptr) {
+    return 0;
+  }
+  if (n->type == JSON_DOM_INT) {
+    return n->data.intValue;
+  }
+  if (n->type == JSON_DOM_FLOAT) {
+    // clamped like jsonParseInteger()
+    float value = n->data.floatValue;
+    if (value >= (float) LONG_MAX) {
+      return LONG_MAX;
+    }
+    if (value <= (float) LONG_MIN) {
+      return LONG_MIN;
+    }
+    return (long) value;
+  }
+  return 0;
+}
+
+float JsonDomValue::getFloat() const {
+  const JsonDomNode* n = node();
+  if (n == nullptr) {
+    return 0;
+  }
+  if (n->type == JSON_DOM_FLOAT) {
+    return n->data.floatValue;
+  }
+  if (n->type == JSON_DOM_INT) {
+    return (float) n->data.intValue;
+  }
+  return 0;
+}
+
+const char* JsonDomValue::getString() const {
+  const JsonDomNode* n = node();
+  if (n == nullptr || n->type != JSON_DOM_STRING) {
+    return "";
+  }
+  return dom->stringAt(n->data.stringOffset);
+}
+
+const char* JsonDomValue::getKey() const {
+  const JsonDomNode* n = node();
+  if (n == nullptr || n->key == JSON_DOM_NONE) {
+    return "";
+  }
+  return dom->stringAt(n->key);
+}
+
+int JsonDomValue::size() const {
+  const JsonDomNode* n = node();
+  if (n == nullptr || (n->type != JSON_DOM_OBJECT && n->type != JSON_DOM_ARRAY)) {
+    return 0;
+  }
+  return n->count;
+}
+
+JsonDomValue JsonDomValue::operator[](const char* key) const {
+  const JsonDomNode* n = node();
+  if (n == nullptr || n->type != JSON_DOM_OBJECT) {
+    return JsonDomValue();
+  }
+  uint16_t child = index + 1;
+  for (uint16_t i = 0; i < n->count; i++) {
+    const JsonDomNode& c = dom->nodes[child];
+    if (c.key != JSON_DOM_NONE && strcmp(dom->stringAt(c.key), key) == 0) {
+      return JsonDomValue(dom, child);
+    }
+    child += 1 + c.span;
+  }
+  return JsonDomValue();
+}
+
+JsonDomValue JsonDomValue::operator[](int position) const {
+  const JsonDomNode* n = node();
+  if (n == nullptr || position < 0 || position >= size()) {
+    return JsonDomValue();
+  }
+  uint16_t child = index + 1;
+  for (int i = 0; i < position; i++) {
+    child += 1 + dom->nodes[child].span;
+  }
+  return JsonDomValue(dom, child);
+}
+
+JsonDomBuilder::JsonDomBuilder(uint8_t* arena, size_t arenaSize, JsonHandler* next) {
+  // nodes need natural alignment, strings don't
+  size_t padding = (sizeof(void*) - ((uintptr_t) arena % sizeof(void*))) % sizeof(void*);
+  if (arenaSize > 0xFFFE) {
+    arenaSize = 0xFFFE;
+  }
+  if (arenaSize < padding) {
+    arenaSize = padding;
+  }
+  this->arena = arena;
+  this->arenaSize = arenaSize;
+  this->next = next;
+  this->nodes = (JsonDomNode*) (arena + padding);
+  this->maxNodes = (uint16_t) ((arenaSize - padding) / sizeof(JsonDomNode));
+  clear();
+}
+
+bool JsonDomBuilder::select(uint32_t pathHash) {
+  if (selectorCount >= JSON_DOM_MAX_SELECTORS) {
+    return false;
+  }
+  selectors[selectorCount++] = pathHash;
+  return true;
+}
+
+void JsonDomBuilder::clear() {
+  nodeCount = 0;
+  stringTop = arenaSize;
+  rootCount = 0;
+  depth = 0;
+  capturing = false;
+  skipDepth = 0;
+  overflowed = false;
+}
+
+JsonDomValue JsonDomBuilder::getRoot(int position) const {
+  if (position < 0 || position >= rootCount) {
+    return JsonDomValue();
+  }
+  return JsonDomValue(this, roots[position]);
+}
+
+JsonDomValue JsonDomBuilder::get(uint32_t pathHash) const {
+  for (int i = 0; i < rootCount; i++) {
+    if (rootHashes[i] == pathHash) {
+      return JsonDomValue(this, roots[i]);
+    }
+  }
+  return JsonDomValue();
+}
+
+size_t JsonDomBuilder::getUsedSize() const {
+  return ((uint8_t*) nodes - arena) + nodeCount * sizeof(JsonDomNode) + (arenaSize - stringTop);
+}
+
+const char* JsonDomBuilder::stringAt(uint16_t offset) const {
+  return (const char*) arena + offset;
+}
+
+bool JsonDomBuilder::isSelected(ElementPath& path, uint32_t& hash) {
+  if (selectorCount == 0 || rootCount >= JSON_DOM_MAX_ROOTS) {
+    return false;
+  }
+  hash = jsonPathHashOf(path);
+  for (int i = 0; i < selectorCount; i++) {
+    if (selectors[i] == hash) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint16_t JsonDomBuilder::storeString(const char* value, bool intern) {
+  size_t length = strlen(value);
+  if (intern) {
+    // any equal string already in the arena will do
+    size_t offset = stringTop;
+    while (offset < arenaSize) {
+      const char* existing = (const char*) arena + offset;
+      size_t existingLength = strlen(existing);
+      if (existingLength == length && memcmp(existing, value, length) == 0) {
+        return (uint16_t) offset;
+      }
+      offset += existingLength + 1;
+    }
+  }
+  size_t nodesEnd = ((uint8_t*) nodes - arena) + nodeCount * sizeof(JsonDomNode);
+  if (stringTop < nodesEnd + length + 1) {
+    return JSON_DOM_NONE;
+  }
+  stringTop -= length + 1;
+  memcpy(arena + stringTop, value, length + 1);
+  return (uint16_t) stringTop;
+}
+
+bool JsonDomBuilder::addNode(uint8_t type, ElementPath& path, uint16_t& index) {
+  uint16_t key = JSON_DOM_NONE;
+  if (path.getCount() > 0 && path.getCurrent()->isObject()) {
+    key = storeString(path.getKey(), true);
+    if (key == JSON_DOM_NONE) {
+      return false;
+    }
+  }
+  size_t nodesEnd = ((uint8_t*) nodes - arena) + (nodeCount + 1) * sizeof(JsonDomNode);
+  if (nodeCount >= maxNodes || nodesEnd > stringTop) {
+    return false;
+  }
+  index = nodeCount++;
+  JsonDomNode& node = nodes[index];
+  node.type = type;
+  node.key = key;
+  node.span = 0;
+  node.count = 0;
+  node.data.intValue = 0;
+  if (depth > 0) {
+    nodes[openNodes[depth - 1]].count++;
+  }
+  return true;
+}
+
+void JsonDomBuilder::abortCapture() {
+  // drop the partial subtree and ignore the rest of it
+  nodeCount = captureNodeCount;
+  stringTop = captureStringTop;
+  skipDepth = depth;
+  depth = 0;
+  capturing = false;
+  overflowed = true;
+}
+
+void JsonDomBuilder::beginContainer(uint8_t type, ElementPath& path) {
+  if (skipDepth > 0) {
+    skipDepth++;
+    return;
+  }
+  if (!capturing) {
+    uint32_t hash;
+    if (!isSelected(path, hash)) {
+      return;
+    }
+    capturing = true;
+    captureHash = hash;
+    captureNodeCount = nodeCount;
+    captureStringTop = stringTop;
+  }
+  uint16_t index;
+  if (depth >= JSON_DOM_MAX_DEPTH || !addNode(type, path, index)) {
+    depth++;
+    abortCapture();
+    return;
+  }
+  openNodes[depth++] = index;
+}
+
+void JsonDomBuilder::endContainer() {
+  if (skipDepth > 0) {
+    skipDepth--;
+    return;
+  }
+  if (!capturing) {
+    return;
+  }
+  uint16_t index = openNodes[--depth];
+  nodes[index].span = nodeCount - index - 1;
+  if (depth == 0) {
+    roots[rootCount] = index;
+    rootHashes[rootCount] = captureHash;
+    rootCount++;
+    capturing = false;
+  }
+}
+
+void JsonDomBuilder::startDocument() {
+  clear();
+  if (next != nullptr) {
+    next->startDocument();
+  }
+}
+
+void JsonDomBuilder::endDocument() {
+  if (next != nullptr) {
+    next->endDocument();
+  }
+}
+
+void JsonDomBuilder::startObject(ElementPath path) {
+  beginContainer(JSON_DOM_OBJECT, path);
+  if (next != nullptr) {
+    next->startObject(path);
+  }
+}
+
+void JsonDomBuilder::endObject(ElementPath path) {
+  endContainer();
+  if (next != nullptr) {
+    next->endObject(path);
+  }
+}
+
+void JsonDomBuilder::startArray(ElementPath path) {
+  beginContainer(JSON_DOM_ARRAY, path);
+  if (next != nullptr) {
+    next->startArray(path);
+  }
+}
+
+void JsonDomBuilder::endArray(ElementPath path) {
+  endContainer();
+  if (next != nullptr) {
+    next->endArray(path);
+  }
+}
+
+void JsonDomBuilder::value(ElementPath path, ElementValue value) {
+  if (next != nullptr) {
+    next->value(path, value);
+  }
+  if (skipDepth > 0) {
+    return;
+  }
+
+  uint32_t hash = 0;
+  bool isRoot = false;
+  if (!capturing) {
+    if (!isSelected(path, hash)) {
+      return;
+    }
+    isRoot = true;
+    captureNodeCount = nodeCount;
+    captureStringTop = stringTop;
+  }
+
+  uint8_t type = JSON_DOM_NULL;
+  if (value.isBool()) {
+    type = JSON_DOM_BOOL;
+  } else if (value.isInt()) {
+    int64_t mantissa;
+    int exponent;
+    value.getDecimal(&mantissa, &exponent);
+    // integers beyond int32_t are kept as (approximate) floats rather than wrapped
+    type = exponent == 0 && mantissa >= INT32_MIN && mantissa <= INT32_MAX ? JSON_DOM_INT : JSON_DOM_FLOAT;
+  } else if (value.isFloat()) {
+    type = JSON_DOM_FLOAT;
+  } else if (value.isString()) {
+    type = JSON_DOM_STRING;
+  }
+
+  uint16_t index;
+  if (!addNode(type, path, index)) {
+    abortCapture();
+    return;
+  }
+  JsonDomNode& node = nodes[index];
+  switch (type) {
+    case JSON_DOM_BOOL:
+      node.data.boolValue = value.getBool();
+      break;
+    case JSON_DOM_INT:
+      node.data.intValue = (int32_t) value.getInt();
+      break;
+    case JSON_DOM_FLOAT:
+      node.data.floatValue = value.getFloat();
+      break;
+    case JSON_DOM_STRING: {
+      uint16_t offset = storeString(value.getString(), false);
+      if (offset == JSON_DOM_NONE) {
+        abortCapture();
+        return;
+      }
+      // storeString() may not move nodes, so the reference is still valid
+      node.data.stringOffset = offset;
+    } break;
+  }
+
+  if (isRoot) {
+    roots[rootCount] = index;
+    rootHashes[rootCount] = hash;
+    rootCount++;
+  }
+}
+
+void JsonDomBuilder::whitespace(char c) {
+  if (next != nullptr) {
+    next->whitespace(c);
+  }
+}
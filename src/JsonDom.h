@@ -0,0 +1,225 @@
+#ifndef JSON_DOM_H
+#define JSON_DOM_H
+
+#include <Arduino.h>
+#include "JsonHandler.h"
+#include "JsonPathHash.h"
+
+#ifndef JSON_DOM_MAX_SELECTORS
+#define JSON_DOM_MAX_SELECTORS   4
+#endif
+
+#ifndef JSON_DOM_MAX_ROOTS
+#define JSON_DOM_MAX_ROOTS       8
+#endif
+
+#ifndef JSON_DOM_MAX_DEPTH
+#define JSON_DOM_MAX_DEPTH       JSON_PARSER_PATH_MAX_DEPTH
+#endif
+
+#define JSON_DOM_NONE            0xFFFF
+
+enum JsonDomType {
+  JSON_DOM_NULL,
+  JSON_DOM_BOOL,
+  JSON_DOM_INT,
+  JSON_DOM_FLOAT,
+  JSON_DOM_STRING,
+  JSON_DOM_OBJECT,
+  JSON_DOM_ARRAY
+};
+
+/*
+  Arena node. Nodes of a subtree are stored contiguously in document order,
+  so a container's children start right after it and span tells how many
+  nodes its whole subtree covers.
+*/
+struct JsonDomNode {
+  uint8_t type;
+  uint16_t key;       // arena offset of the interned key, JSON_DOM_NONE for array items
+  uint16_t span;      // descendants count (containers)
+  uint16_t count;     // children count (containers)
+  union {
+    bool boolValue;
+    int32_t intValue;
+    float floatValue;
+    uint16_t stringOffset;
+  } data;
+};
+
+class JsonDomBuilder;
+
+/*
+  Read-only handle to a node; invalid handles (missing keys, out of range
+  indices...) behave as null.
+*/
+class JsonDomValue {
+  friend class JsonDomBuilder;
+
+  private:
+    const JsonDomBuilder* dom;
+    uint16_t index;
+
+    JsonDomValue(const JsonDomBuilder* dom, uint16_t index) : dom(dom), index(index) { }
+
+    const JsonDomNode* node() const;
+
+  public:
+    JsonDomValue() : dom(nullptr), index(JSON_DOM_NONE) { }
+
+    bool isValid() const { return node() != nullptr; }
+
+    int getType() const;
+
+    bool isNull() const { return getType() == JSON_DOM_NULL; }
+    bool isBool() const { return getType() == JSON_DOM_BOOL; }
+    // integers beyond the int32_t range are stored as floats
+    bool isInt() const { return getType() == JSON_DOM_INT; }
+    bool isFloat() const { return getType() == JSON_DOM_FLOAT; }
+    bool isString() const { return getType() == JSON_DOM_STRING; }
+    bool isObject() const { return getType() == JSON_DOM_OBJECT; }
+    bool isArray() const { return getType() == JSON_DOM_ARRAY; }
+
+    bool getBool() const;
+
+    long getInt() const;
+
+    float getFloat() const;
+
+    /*
+      String value, "" if not a string.
+    */
+    const char* getString() const;
+
+    /*
+      Key of this node within its parent object, "" for array items.
+    */
+    const char* getKey() const;
+
+    /*
+      Children count (containers), 0 otherwise.
+    */
+    int size() const;
+
+    /*
+      Object member lookup.
+    */
+    JsonDomValue operator[](const char* key) const;
+
+    /*
+      Array item (or object member by position).
+    */
+    JsonDomValue operator[](int position) const;
+};
+
+/*
+  Opt-in JsonHandler building a compact DOM of selected subtrees only.
+
+  Subtrees are selected by normalized path (see JsonPathHash.h); everything
+  else just streams through (to the optional next handler, which receives
+  every event). Nodes, strings and interned keys live in a caller-provided
+  arena (up to 64 KB): no malloc, no heap fragmentation. The arena is
+  recycled at each startDocument().
+
+    uint8_t arena[1024];
+    JsonDomBuilder dom(arena, sizeof(arena), &myHandler);
+    dom.select(jsonPathHash("city"));
+    parser.setHandler(&dom);
+    ...
+    const char* name = dom.get(jsonPathHash("city"))["name"].getString();
+*/
+class JsonDomBuilder: public JsonHandler {
+  friend class JsonDomValue;
+
+  private:
+    uint8_t* arena;
+    size_t arenaSize;
+    JsonHandler* next;
+
+    JsonDomNode* nodes;
+    uint16_t nodeCount = 0;
+    uint16_t maxNodes;
+    // strings and keys grow down from the end of the arena
+    size_t stringTop;
+
+    uint32_t selectors[JSON_DOM_MAX_SELECTORS];
+    int selectorCount = 0;
+
+    uint32_t rootHashes[JSON_DOM_MAX_ROOTS];
+    uint16_t roots[JSON_DOM_MAX_ROOTS];
+    int rootCount = 0;
+
+    uint16_t openNodes[JSON_DOM_MAX_DEPTH];
+    int depth = 0;
+    bool capturing = false;
+    uint32_t captureHash = 0;
+    uint16_t captureNodeCount = 0;
+    size_t captureStringTop = 0;
+    // nesting left to skip after an arena overflow aborted a capture
+    int skipDepth = 0;
+    bool overflowed = false;
+
+    bool isSelected(ElementPath& path, uint32_t& hash);
+
+    uint16_t storeString(const char* value, bool intern);
+
+    bool addNode(uint8_t type, ElementPath& path, uint16_t& index);
+
+    void abortCapture();
+
+    void beginContainer(uint8_t type, ElementPath& path);
+
+    void endContainer();
+
+    const char* stringAt(uint16_t offset) const;
+
+  public:
+    JsonDomBuilder(uint8_t* arena, size_t arenaSize, JsonHandler* next = nullptr);
+
+    /*
+      Selects the subtree (or single value) at the given normalized path hash,
+      e.g. jsonPathHash("city") or jsonPathHash("list[].main").
+    */
+    bool select(uint32_t pathHash);
+
+    void clear();
+
+    /*
+      Captured subtrees, in document order. When a selected path occurs more
+      than once (e.g. "list[].main"), every occurrence is captured, up to
+      JSON_DOM_MAX_ROOTS.
+    */
+    int getRootCount() const { return rootCount; }
+
+    JsonDomValue getRoot(int position) const;
+
+    /*
+      First captured subtree for the given selector.
+    */
+    JsonDomValue get(uint32_t pathHash) const;
+
+    bool hasOverflowed() const { return overflowed; }
+
+    /*
+      Arena bytes in use.
+    */
+    size_t getUsedSize() const;
+
+    virtual void startDocument();
+
+    virtual void endDocument();
+
+    virtual void startObject(ElementPath path);
+
+    virtual void endObject(ElementPath path);
+
+    virtual void startArray(ElementPath path);
+
+    virtual void endArray(ElementPath path);
+
+    virtual void value(ElementPath path, ElementValue value);
+
+    virtual void whitespace(char c);
+};
+
+#endif // JSON_DOM_H
@@ -0,0 +1,385 @@
+#include "JsonEventLog.h"
+#include "JsonPathHash.h"
+
+static uint16_t keyHash(const char* key) {
+  uint32_t hash = JSON_PATH_HASH_SEED;
+  while (*key) {
+    hash = jsonPathHashStep(hash, *key++);
+  }
+  return (uint16_t) (hash ^ (hash >> 16));
+}
+
+JsonEventRecorder::JsonEventRecorder(JsonSink* sink, JsonEventLogKey* keys, int maxKeys, char* keyStorage, size_t keyStorageSize) {
+  this->sink = sink;
+  this->keys = keys;
+  this->maxKeys = maxKeys < 65535 ? maxKeys : 65535;
+  this->keyStorage = keyStorage;
+  this->keyStorageSize = keyStorageSize < 65535 ? keyStorageSize : 65535;
+}
+
+void JsonEventRecorder::reset() {
+  keyCount = 0;
+  keyStorageUsed = 0;
+  headerWritten = false;
+}
+
+void JsonEventRecorder::writeVarint(unsigned long value) {
+  while (value >= 0x80) {
+    sink->write((char) (value | 0x80));
+    value >>= 7;
+  }
+  sink->write((char) value);
+}
+
+void JsonEventRecorder::writeText(const char* text, size_t length) {
+  writeVarint(length);
+  sink->write(text, length + 1);
+}
+
+/*
+  Writes the key of the current element, if it is an object member.
+*/
+void JsonEventRecorder::writeKey(ElementPath& path) {
+  ElementSelector* current = path.getCurrent();
+  if (current == NULL || !current->isObject()) {
+    return;
+  }
+  const char* key = current->getKey();
+  uint16_t hash = keyHash(key);
+  for (uint16_t i = 0; i < keyCount; i++) {
+    if (keys[i].hash == hash && strcmp(keyStorage + keys[i].offset, key) == 0) {
+      sink->write((char) JSON_OP_KEY_REF);
+      writeVarint(i);
+      return;
+    }
+  }
+
+  size_t length = strlen(key);
+  if (keyCount < maxKeys && keyStorageUsed + length + 1 <= keyStorageSize) {
+    keys[keyCount].hash = hash;
+    keys[keyCount].offset = keyStorageUsed;
+    memcpy(keyStorage + keyStorageUsed, key, length + 1);
+    keyStorageUsed += length + 1;
+    keyCount++;
+    sink->write((char) JSON_OP_KEY_DEFINE);
+  } else {
+    sink->write((char) JSON_OP_KEY);
+  }
+  writeText(key, length);
+}
+
+void JsonEventRecorder::startDocument() {
+  if (!headerWritten) {
+    sink->write('J');
+    sink->write('E');
+    sink->write((char) JSON_EVENT_LOG_VERSION);
+    headerWritten = true;
+  }
+  sink->write((char) JSON_OP_START_DOCUMENT);
+}
+
+void JsonEventRecorder::endDocument() {
+  sink->write((char) JSON_OP_END_DOCUMENT);
+}
+
+void JsonEventRecorder::startObject(ElementPath path) {
+  writeKey(path);
+  sink->write((char) JSON_OP_START_OBJECT);
+}
+
+void JsonEventRecorder::endObject(ElementPath /* path */) {
+  sink->write((char) JSON_OP_END_OBJECT);
+}
+
+void JsonEventRecorder::startArray(ElementPath path) {
+  writeKey(path);
+  sink->write((char) JSON_OP_START_ARRAY);
+}
+
+void JsonEventRecorder::endArray(ElementPath /* path */) {
+  sink->write((char) JSON_OP_END_ARRAY);
+}
+
+void JsonEventRecorder::value(ElementPath path, ElementValue value) {
+  writeKey(path);
+  if (value.isInt()) {
+    long intValue = value.getInt();
+    sink->write((char) JSON_OP_INT);
+    writeVarint(((unsigned long) intValue << 1) ^ (unsigned long) (intValue < 0 ? -1L : 0L));
+  } else if (value.isFloat()) {
+    float floatValue = value.getFloat();
+    uint32_t bits;
+    memcpy(&bits, &floatValue, sizeof(bits));
+    char bytes[4] = { (char) bits, (char) (bits >> 8), (char) (bits >> 16), (char) (bits >> 24) };
+    sink->write((char) JSON_OP_FLOAT);
+    sink->write(bytes, sizeof(bytes));
+  } else if (value.isString()) {
+    sink->write((char) JSON_OP_STRING);
+    writeText(value.getString(), strlen(value.getString()));
+  } else if (value.isBool()) {
+    sink->write((char) (value.getBool() ? JSON_OP_TRUE : JSON_OP_FALSE));
+  } else {
+    sink->write((char) JSON_OP_NULL);
+  }
+}
+
+void JsonEventRecorder::whitespace(char /* c */) {
+}
+
+/*
+  Log in memory: strings are used in place.
+*/
+struct JsonEventLogBufferSource {
+  const uint8_t* data;
+  const uint8_t* end;
+
+  bool available() { return data < end; }
+
+  int read() { return data < end ? *data++ : -1; }
+
+  bool readBytes(uint8_t* bytes, size_t length) {
+    if ((size_t) (end - data) < length) {
+      return false;
+    }
+    memcpy(bytes, data, length);
+    data += length;
+    return true;
+  }
+
+  const char* readText(JsonEventReplayer& replayer, unsigned long length, bool /* key */) {
+    if ((size_t) (end - data) <= length || data[length] != '\0') {
+      replayer.setError("Truncated event log");
+      return nullptr;
+    }
+    const char* text = (const char*) data;
+    data += length + 1;
+    return text;
+  }
+};
+
+/*
+  Log read from a stream: strings are copied into the replayer's buffer,
+  keys into its key storage.
+*/
+struct JsonEventLogStreamSource {
+  Stream* in;
+
+  bool available() { return in->available() > 0; }
+
+  int read() { return in->read(); }
+
+  bool readBytes(uint8_t* bytes, size_t length) {
+    return in->readBytes((char*) bytes, length) == length;
+  }
+
+  const char* readText(JsonEventReplayer& replayer, unsigned long length, bool key) {
+    char* text;
+    if (key) {
+      if (length >= (unsigned long) (replayer.keyStorageSize - replayer.keyStorageUsed)) {
+        replayer.setError("Key storage overflow");
+        return nullptr;
+      }
+      text = replayer.keyStorage + replayer.keyStorageUsed;
+    } else {
+      if (length >= replayer.bufferSize) {
+        replayer.setError("Buffer overflow - string too long");
+        return nullptr;
+      }
+      text = replayer.buffer;
+    }
+    if (in->readBytes(text, length + 1) != length + 1 || text[length] != '\0') {
+      replayer.setError("Truncated event log");
+      return nullptr;
+    }
+    return text;
+  }
+};
+
+JsonEventReplayer::JsonEventReplayer(const char** keys, int maxKeys, char* keyStorage, size_t keyStorageSize, char* buffer, int bufferSize,
+                                     ElementSelector* selectors, int pathDepth, char* pathKeys, int keyLength)
+  : path(selectors, pathDepth, pathKeys, pathDepth * keyLength) {
+  this->keys = keys;
+  this->maxKeys = maxKeys < 65535 ? maxKeys : 65535;
+  this->keyStorage = keyStorage;
+  this->keyStorageSize = keyStorageSize < 65535 ? keyStorageSize : 65535;
+  this->buffer = buffer;
+  this->bufferSize = bufferSize < 65535 ? bufferSize : 65535;
+}
+
+void JsonEventReplayer::setError(const char* message) {
+  hasError = true;
+  errorMessage = message;
+}
+
+bool JsonEventReplayer::replay(const uint8_t* log, size_t length, JsonHandler* handler) {
+  JsonEventLogBufferSource source = { log, log + length };
+  return run(source, handler);
+}
+
+bool JsonEventReplayer::replay(Stream& in, JsonHandler* handler) {
+  JsonEventLogStreamSource source = { &in };
+  return run(source, handler);
+}
+
+/*
+  Moves on to the next element once an array member is complete.
+*/
+void JsonEventReplayer::endMember() {
+  ElementSelector* current = path.getCurrent();
+  if (current != NULL && !current->isObject()) {
+    current->step();
+  }
+}
+
+template <class Source>
+bool JsonEventReplayer::run(Source& source, JsonHandler* handler) {
+  path.reset();
+  keyCount = 0;
+  keyStorageUsed = 0;
+  hasError = false;
+  errorMessage = nullptr;
+
+  uint8_t header[JSON_EVENT_LOG_HEADER_SIZE];
+  if (!source.readBytes(header, sizeof(header)) || header[0] != 'J' || header[1] != 'E'
+      || header[2] != JSON_EVENT_LOG_VERSION) {
+    setError("Invalid event log");
+    return false;
+  }
+
+  ElementValue elementValue;
+  bool inDocument = false;
+  while (!hasError && source.available()) {
+    int opcode = source.read();
+    unsigned long operand = 0;
+    if (opcode == JSON_OP_KEY_DEFINE || opcode == JSON_OP_KEY_REF || opcode == JSON_OP_KEY
+        || opcode == JSON_OP_INT || opcode == JSON_OP_STRING) {
+      int b;
+      uint8_t shift = 0;
+      do {
+        b = source.read();
+        if (b < 0 || shift >= 8 * sizeof(operand)) {
+          setError("Truncated event log");
+          return false;
+        }
+        operand |= (unsigned long) (b & 0x7F) << shift;
+        shift += 7;
+      } while (b & 0x80);
+    }
+
+    switch (opcode) {
+    case JSON_OP_START_DOCUMENT:
+      path.reset();
+      inDocument = true;
+      handler->startDocument();
+      break;
+    case JSON_OP_END_DOCUMENT:
+      inDocument = false;
+      handler->endDocument();
+      break;
+    case JSON_OP_START_OBJECT:
+    case JSON_OP_START_ARRAY:
+      if (opcode == JSON_OP_START_OBJECT) {
+        handler->startObject(path);
+      } else {
+        handler->startArray(path);
+      }
+      if (!path.push()) {
+        setError(path.getCount() < path.getCapacity() ? "Path overflow - keys too long"
+                                                      : "Path overflow - JSON too deeply nested");
+        break;
+      }
+      if (opcode == JSON_OP_START_ARRAY) {
+        // the index of the first element
+        path.getCurrent()->step();
+      }
+      break;
+    case JSON_OP_END_OBJECT:
+    case JSON_OP_END_ARRAY:
+      if (path.getCount() == 0) {
+        setError("Invalid event log");
+        break;
+      }
+      path.pop();
+      if (opcode == JSON_OP_END_OBJECT) {
+        handler->endObject(path);
+      } else {
+        handler->endArray(path);
+      }
+      endMember();
+      break;
+    case JSON_OP_KEY_DEFINE:
+    case JSON_OP_KEY:
+    case JSON_OP_KEY_REF: {
+      if (path.getCurrent() == NULL || !path.getCurrent()->isObject()) {
+        setError("Invalid event log");
+        break;
+      }
+      const char* key;
+      if (opcode == JSON_OP_KEY_REF) {
+        if (operand >= keyCount) {
+          setError("Invalid event log");
+          break;
+        }
+        key = keys[operand];
+      } else {
+        bool define = opcode == JSON_OP_KEY_DEFINE;
+        if (define && keyCount >= maxKeys) {
+          setError("Key storage overflow");
+          break;
+        }
+        key = source.readText(*this, operand, define);
+        if (key == nullptr) {
+          break;
+        }
+        if (define) {
+          keys[keyCount++] = key;
+          if (key == keyStorage + keyStorageUsed) {
+            keyStorageUsed += operand + 1;
+          }
+        }
+      }
+      if (!path.setKey(key)) {
+        setError("Path overflow - keys too long");
+      }
+    } break;
+    case JSON_OP_NULL:
+      handler->value(path, elementValue.with());
+      endMember();
+      break;
+    case JSON_OP_FALSE:
+    case JSON_OP_TRUE:
+      handler->value(path, elementValue.with(opcode == JSON_OP_TRUE));
+      endMember();
+      break;
+    case JSON_OP_INT:
+      handler->value(path, elementValue.with((long) ((operand >> 1) ^ (0 - (operand & 1)))));
+      endMember();
+      break;
+    case JSON_OP_FLOAT: {
+      uint8_t bytes[4];
+      if (!source.readBytes(bytes, sizeof(bytes))) {
+        setError("Truncated event log");
+        break;
+      }
+      uint32_t bits = bytes[0] | (uint32_t) bytes[1] << 8 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+      float floatValue;
+      memcpy(&floatValue, &bits, sizeof(floatValue));
+      handler->value(path, elementValue.with(floatValue));
+      endMember();
+    } break;
+    case JSON_OP_STRING: {
+      const char* text = source.readText(*this, operand, false);
+      if (text != nullptr) {
+        handler->value(path, elementValue.with(text));
+        endMember();
+      }
+    } break;
+    default:
+      setError("Invalid event log");
+    }
+  }
+  if (inDocument && !hasError) {
+    setError("Truncated event log");
+  }
+  return !hasError;
+}
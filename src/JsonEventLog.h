@@ -0,0 +1,182 @@
+#ifndef JSON_EVENT_LOG_H
+#define JSON_EVENT_LOG_H
+
+#include <Arduino.h>
+#include "JsonHandler.h"
+#include "JsonSink.h"
+
+/*
+  Binary event log: a recorded stream of JsonHandler events that can be
+  replayed into any handler without lexing, unescaping or number parsing.
+
+  Layout: the 3 byte header 'J' 'E' JSON_EVENT_LOG_VERSION, then one
+  opcode per event followed by its operands. Counts, lengths and key ids
+  are LEB128 varints, integers are zigzag varints, floats are 4 bytes
+  little-endian, and strings are length-prefixed and NUL-terminated so
+  they can be handed out in place. Object keys are interned: the first
+  occurrence defines an id, later ones only refer to it. Array indices
+  are implicit.
+*/
+
+#define JSON_EVENT_LOG_VERSION  1
+#define JSON_EVENT_LOG_HEADER_SIZE  3
+
+enum JsonEventOpcode : uint8_t {
+  JSON_OP_START_DOCUMENT  = 0x01,
+  JSON_OP_END_DOCUMENT    = 0x02,
+  JSON_OP_START_OBJECT    = 0x03,
+  JSON_OP_END_OBJECT      = 0x04,
+  JSON_OP_START_ARRAY     = 0x05,
+  JSON_OP_END_ARRAY       = 0x06,
+  // key text, interned under the next id
+  JSON_OP_KEY_DEFINE      = 0x07,
+  // key id
+  JSON_OP_KEY_REF         = 0x08,
+  // key text, not interned (the key table is full)
+  JSON_OP_KEY             = 0x09,
+  JSON_OP_NULL            = 0x0A,
+  JSON_OP_FALSE           = 0x0B,
+  JSON_OP_TRUE            = 0x0C,
+  JSON_OP_INT             = 0x0D,
+  JSON_OP_FLOAT           = 0x0E,
+  JSON_OP_STRING          = 0x0F
+};
+
+/*
+  Interned key: hash of its text and offset in the key storage.
+*/
+struct JsonEventLogKey {
+  uint16_t hash;
+  uint16_t offset;
+};
+
+/*
+  Handler recording the events it receives into a sink (a buffer, or a
+  file through JsonSink(&file, ...)). Whitespace is not recorded.
+
+  Interned keys are kept in caller-provided storage: maxKeys entries and
+  keyStorageSize chars for their text; once full, further new keys are
+  written out in full every time.
+*/
+class JsonEventRecorder: public JsonHandler {
+  private:
+    JsonSink* sink;
+    JsonEventLogKey* keys;
+    char* keyStorage;
+    uint16_t keyStorageSize;
+    uint16_t keyStorageUsed = 0;
+    uint16_t keyCount = 0;
+    uint16_t maxKeys;
+    bool headerWritten = false;
+
+    void writeVarint(unsigned long value);
+    void writeText(const char* text, size_t length);
+    void writeKey(ElementPath& path);
+
+  public:
+    JsonEventRecorder(JsonSink* sink, JsonEventLogKey* keys, int maxKeys, char* keyStorage, size_t keyStorageSize);
+
+    /*
+      Starts a new log: the header and key definitions are written again.
+    */
+    void reset();
+
+    bool hasOverflowed() const { return sink->hasOverflowed(); }
+
+    virtual void startDocument();
+    virtual void endDocument();
+    virtual void startObject(ElementPath path);
+    virtual void endObject(ElementPath path);
+    virtual void startArray(ElementPath path);
+    virtual void endArray(ElementPath path);
+    virtual void value(ElementPath path, ElementValue value);
+    virtual void whitespace(char c);
+};
+
+/*
+  Recorder embedding its key table.
+*/
+template <int MAX_KEYS, int KEY_STORAGE_SIZE>
+class StaticJsonEventRecorder: public JsonEventRecorder {
+  private:
+    JsonEventLogKey keyEntries[MAX_KEYS];
+    char keyText[KEY_STORAGE_SIZE];
+
+  public:
+    StaticJsonEventRecorder(JsonSink* sink)
+      : JsonEventRecorder(sink, keyEntries, MAX_KEYS, keyText, KEY_STORAGE_SIZE) { }
+};
+
+/*
+  Drives a handler from a recorded log, with the element paths and values
+  of the original parse.
+
+  Logs in memory are replayed in place: strings and keys point into the
+  log, so it must stay valid during the replay. Logs read from a Stream
+  (e.g. a file) go through the string buffer (bufferSize chars, as for the
+  parser) and the key storage (keyStorageSize chars), which must be at
+  least as large as the recorder's.
+*/
+class JsonEventReplayer {
+  friend struct JsonEventLogBufferSource;
+  friend struct JsonEventLogStreamSource;
+
+  private:
+    ElementPath path;
+
+    const char** keys;
+    char* keyStorage;
+    char* buffer;
+
+    const char* errorMessage = nullptr;
+
+    uint16_t maxKeys;
+    uint16_t keyCount = 0;
+    uint16_t keyStorageSize;
+    uint16_t keyStorageUsed = 0;
+    uint16_t bufferSize;
+
+    bool hasError = false;
+
+    template <class Source>
+    bool run(Source& source, JsonHandler* handler);
+
+    void endMember();
+
+    void setError(const char* message);
+
+  public:
+    JsonEventReplayer(const char** keys, int maxKeys, char* keyStorage, size_t keyStorageSize, char* buffer, int bufferSize,
+                      ElementSelector* selectors, int pathDepth, char* pathKeys, int keyLength);
+
+    /*
+      Replays all documents of the log into handler. Returns false on a
+      corrupt or truncated log, or when it does not fit the storage.
+    */
+    bool replay(const uint8_t* log, size_t length, JsonHandler* handler);
+    bool replay(Stream& in, JsonHandler* handler);
+
+    bool hasReplayError() const { return hasError; }
+    const char* getErrorMessage() const { return errorMessage; }
+};
+
+/*
+  Replayer embedding its own storage. For in-memory logs only, KEY_STORAGE
+  and BUFFER_SIZE may be 1.
+*/
+template <int MAX_KEYS, int KEY_STORAGE_SIZE, int BUFFER_SIZE, int PATH_DEPTH, int KEY_LENGTH>
+class StaticJsonEventReplayer: public JsonEventReplayer {
+  private:
+    const char* keyEntries[MAX_KEYS];
+    char keyText[KEY_STORAGE_SIZE];
+    char bufferStorage[BUFFER_SIZE];
+    ElementSelector selectorStorage[PATH_DEPTH];
+    char pathKeyStorage[PATH_DEPTH * KEY_LENGTH];
+
+  public:
+    StaticJsonEventReplayer()
+      : JsonEventReplayer(keyEntries, MAX_KEYS, keyText, KEY_STORAGE_SIZE, bufferStorage, BUFFER_SIZE,
+                          selectorStorage, PATH_DEPTH, pathKeyStorage, KEY_LENGTH) { }
+};
+
+#endif // JSON_EVENT_LOG_H
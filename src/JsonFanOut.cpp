@@ -0,0 +1,169 @@
+#include "JsonFanOut.h"
+
+// calls the handlers of the routes in mask, each once
+#define FAN_OUT(mask, call) \
+  for (int r = 0; r < routeCount; r++) { \
+    if (((mask) >> r & 1) && !isDelivered(r, mask)) { \
+      routes[r].handler->call; \
+    } \
+  }
+
+#define FAN_OUT_FRAME(level)  (level < JSON_FAN_OUT_MAX_DEPTH ? level : JSON_FAN_OUT_MAX_DEPTH - 1)
+
+bool JsonFanOut::add(JsonHandler* handler, const char* filter) {
+  if (routeCount >= JSON_FAN_OUT_MAX_ROUTES) {
+    return false;
+  }
+  JsonFanOutRoute& route = routes[routeCount];
+  uint8_t depth = 0;
+  uint32_t hash = JSON_PATH_HASH_SEED;
+  for (const char* p = filter; *p; p++) {
+    hash = jsonPathHashStep(hash, *p);
+    // a level ends with its key or "[]", before the next '.' or '['
+    char next = p[1];
+    if (*p != '[' && (next == '\0' || next == '.' || next == '[')) {
+      if (depth >= JSON_FAN_OUT_MAX_DEPTH - 1) {
+        return false;
+      }
+      route.prefixes[depth++] = hash;
+    }
+  }
+  route.handler = handler;
+  route.depth = depth;
+  routeCount++;
+  return true;
+}
+
+bool JsonFanOut::isDelivered(int r, uint32_t routeMask) {
+  for (int i = 0; i < r; i++) {
+    if ((routeMask >> i & 1) && routes[i].handler == routes[r].handler) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+  Routes the current element is in, and those whose filter lies below it.
+*/
+uint32_t JsonFanOut::enter(ElementPath& path, uint32_t& below, uint32_t& hash) {
+  int level = path.getCount();
+  uint32_t inside = 0;
+  below = 0;
+  if (level == 0) {
+    hash = JSON_PATH_HASH_SEED;
+    for (int r = 0; r < routeCount; r++) {
+      if (routes[r].depth == 0) {
+        inside |= 1UL << r;
+      } else {
+        below |= 1UL << r;
+      }
+    }
+    return inside;
+  }
+
+  // filters end above the last frame, so deeper elements just inherit
+  const JsonFanOutFrame& parent = frames[FAN_OUT_FRAME(level - 1)];
+  inside = parent.inside;
+  hash = 0;
+  if (parent.below != 0) {
+    hash = jsonPathHashAppend(parent.hash, path.getCurrent(), level - 1);
+    for (int r = 0; r < routeCount; r++) {
+      if ((parent.below >> r & 1) && routes[r].prefixes[level - 1] == hash) {
+        if (routes[r].depth == level) {
+          inside |= 1UL << r;
+        } else {
+          below |= 1UL << r;
+        }
+      }
+    }
+  }
+  return inside;
+}
+
+void JsonFanOut::startContainer(ElementPath& path, bool array) {
+  uint32_t below, hash;
+  uint32_t inside = enter(path, below, hash);
+  int level = path.getCount();
+  if (level < JSON_FAN_OUT_MAX_DEPTH) {
+    frames[level].hash = hash;
+    frames[level].inside = inside;
+    frames[level].below = below;
+  }
+  current = inside;
+  if (array) {
+    FAN_OUT(inside, startArray(path));
+  } else {
+    FAN_OUT(inside, startObject(path));
+  }
+  if (inside == 0 && below == 0 && parser != nullptr) {
+    parser->skipCurrent();
+  }
+}
+
+void JsonFanOut::endContainer(ElementPath& path, bool array) {
+  int level = path.getCount();
+  uint32_t inside = frames[FAN_OUT_FRAME(level)].inside;
+  if (array) {
+    FAN_OUT(inside, endArray(path));
+  } else {
+    FAN_OUT(inside, endObject(path));
+  }
+  current = level > 0 ? frames[FAN_OUT_FRAME(level - 1)].inside : 0;
+}
+
+void JsonFanOut::startDocument() {
+  uint32_t all = routeCount < 32 ? (1UL << routeCount) - 1 : 0xFFFFFFFFUL;
+  current = 0;
+  FAN_OUT(all, startDocument());
+}
+
+void JsonFanOut::endDocument() {
+  uint32_t all = routeCount < 32 ? (1UL << routeCount) - 1 : 0xFFFFFFFFUL;
+  current = 0;
+  FAN_OUT(all, endDocument());
+}
+
+void JsonFanOut::startObject(ElementPath path) {
+  startContainer(path, false);
+}
+
+void JsonFanOut::endObject(ElementPath path) {
+  endContainer(path, false);
+}
+
+void JsonFanOut::startArray(ElementPath path) {
+  startContainer(path, true);
+}
+
+void JsonFanOut::endArray(ElementPath path) {
+  endContainer(path, true);
+}
+
+void JsonFanOut::value(ElementPath path, ElementValue value) {
+  uint32_t below, hash;
+  uint32_t inside = enter(path, below, hash);
+  FAN_OUT(inside, value(path, value));
+}
+
+void JsonFanOut::values(ElementPath path, const int32_t* data, size_t count, int firstIndex) {
+  uint32_t below, hash;
+  uint32_t inside = enter(path, below, hash);
+  FAN_OUT(inside, values(path, data, count, firstIndex));
+}
+
+void JsonFanOut::values(ElementPath path, const float* data, size_t count, int firstIndex) {
+  uint32_t below, hash;
+  uint32_t inside = enter(path, below, hash);
+  FAN_OUT(inside, values(path, data, count, firstIndex));
+}
+
+void JsonFanOut::values(ElementPath path, const double* data, size_t count, int firstIndex) {
+  uint32_t below, hash;
+  uint32_t inside = enter(path, below, hash);
+  FAN_OUT(inside, values(path, data, count, firstIndex));
+}
+
+void JsonFanOut::whitespace(char c) {
+  FAN_OUT(current, whitespace(c));
+}
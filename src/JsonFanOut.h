@@ -0,0 +1,115 @@
+#ifndef JSON_FAN_OUT_H
+#define JSON_FAN_OUT_H
+
+#include <Arduino.h>
+#include "JsonHandler.h"
+#include "JsonPathHash.h"
+#include "JsonStreamingParser2.h"
+
+#ifndef JSON_FAN_OUT_MAX_ROUTES
+#define JSON_FAN_OUT_MAX_ROUTES  8
+#endif
+
+#ifndef JSON_FAN_OUT_MAX_DEPTH
+#define JSON_FAN_OUT_MAX_DEPTH   8
+#endif
+
+#if JSON_FAN_OUT_MAX_ROUTES > 32
+#error "JSON_FAN_OUT_MAX_ROUTES is limited to 32"
+#endif
+
+/*
+  Handler receiving the subtree below one normalized path (see
+  JsonPathHash.h). prefixes[i] is the hash of the filter's first i + 1
+  levels.
+*/
+struct JsonFanOutRoute {
+  JsonHandler* handler;
+  uint32_t prefixes[JSON_FAN_OUT_MAX_DEPTH];
+  uint8_t depth;
+};
+
+/*
+  Open object or array: its normalized path hash, the routes whose
+  subtree it is in, and the routes whose filter lies further below it.
+*/
+struct JsonFanOutFrame {
+  uint32_t hash;
+  uint32_t inside;
+  uint32_t below;
+};
+
+/*
+  Handler dispatching the events of one parse to several handlers, each
+  receiving only the subtrees it asked for:
+
+    JsonFanOut fanOut;
+    fanOut.add(&cache, "list[].main");
+    fanOut.add(&cache, "city");
+    fanOut.add(&logger, "");             // everything
+    fanOut.setParser(&parser);
+    parser.setHandler(&fanOut);
+
+  A handler gets the events of the element at its filter path and of all
+  elements below it, once even if several of its filters match, plus
+  startDocument() and endDocument(). Objects and arrays no filter reaches
+  into are skipped by the parser (JsonStreamingParserBase::skipCurrent),
+  which then only looks for their end; without setParser() they are
+  parsed but not dispatched.
+
+  Filters are matched level by level on path hashes, so the parser's path
+  tracks them without building strings. Filters may be at most
+  JSON_FAN_OUT_MAX_DEPTH - 1 levels deep.
+*/
+class JsonFanOut: public JsonHandler {
+  private:
+    JsonFanOutRoute routes[JSON_FAN_OUT_MAX_ROUTES];
+    JsonFanOutFrame frames[JSON_FAN_OUT_MAX_DEPTH];
+    JsonStreamingParserBase* parser = nullptr;
+    // routes of the innermost open object or array, for whitespace
+    uint32_t current = 0;
+    int routeCount = 0;
+
+    uint32_t enter(ElementPath& path, uint32_t& below, uint32_t& hash);
+
+    void startContainer(ElementPath& path, bool array);
+
+    void endContainer(ElementPath& path, bool array);
+
+    /*
+      Whether the handler of route r was already given the event by an
+      earlier route.
+    */
+    bool isDelivered(int r, uint32_t routeMask);
+
+  public:
+    /*
+      Routes the subtree at filter, a normalized path such as
+      "list[].main" ("" for the whole document), to handler. Returns false
+      if the routes are used up or the filter is too deep.
+    */
+    bool add(JsonHandler* handler, const char* filter);
+
+    /*
+      Lets the parser skip what no filter reaches into.
+    */
+    void setParser(JsonStreamingParserBase* parser) { this->parser = parser; }
+
+    void clear() { routeCount = 0; }
+
+    int getRouteCount() const { return routeCount; }
+
+    virtual void startDocument();
+    virtual void endDocument();
+    virtual void startObject(ElementPath path);
+    virtual void endObject(ElementPath path);
+    virtual void startArray(ElementPath path);
+    virtual void endArray(ElementPath path);
+    virtual void value(ElementPath path, ElementValue value);
+    virtual void values(ElementPath path, const int32_t* data, size_t count, int firstIndex);
+    virtual void values(ElementPath path, const float* data, size_t count, int firstIndex);
+    virtual void values(ElementPath path, const double* data, size_t count, int firstIndex);
+    virtual void whitespace(char c);
+};
+
+#endif // JSON_FAN_OUT_H
@@ -0,0 +1,43 @@
+#include "JsonFlashReader.h"
+
+#define FLASH_WINDOW_WORDS  (sizeof(window) / sizeof(window[0]))
+
+JsonFlashReader::JsonFlashReader(const char* data, size_t length) {
+  this->data = data;
+  this->length = length;
+}
+
+JsonFlashReader::JsonFlashReader(const char* data) {
+  this->data = data;
+  this->length = strlen_P(data);
+}
+
+size_t JsonFlashReader::pump(JsonStreamingParserBase* parser) {
+  size_t start = position;
+  while (position < length) {
+    // whole words only: the bytes before and after the document share
+    // their words with it, so reading them stays within readable flash
+    uintptr_t address = (uintptr_t) (data + position);
+    uintptr_t aligned = address & ~(uintptr_t) 3;
+    size_t skip = address - aligned;
+    size_t remaining = length - position;
+    size_t words = (skip + remaining + 3) / 4;
+    if (words > FLASH_WINDOW_WORDS) {
+      words = FLASH_WINDOW_WORDS;
+    }
+    for (size_t i = 0; i < words; i++) {
+      window[i] = pgm_read_dword((const uint32_t*) (aligned + 4 * i));
+    }
+
+    size_t run = words * 4 - skip;
+    if (run > remaining) {
+      run = remaining;
+    }
+    size_t consumed = parser->parse((const char*) window + skip, run, data + position);
+    position += consumed;
+    if (consumed < run || parser->isDocumentComplete() || parser->hasParseError()) {
+      break;
+    }
+  }
+  return position - start;
+}
@@ -0,0 +1,67 @@
+#ifndef JSON_FLASH_READER_H
+#define JSON_FLASH_READER_H
+
+#include <Arduino.h>
+#include "JsonStreamingParser2.h"
+
+#ifndef JSON_FLASH_READER_WINDOW
+#define JSON_FLASH_READER_WINDOW  64
+#endif
+
+/*
+  Parses JSON stored in flash (PROGMEM) without a RAM copy of the
+  document. Flash is read in aligned 32-bit words, which is what the
+  ESP8266's flash cache supports natively, into a small RAM window that
+  goes to the parser's bulk path; bytes of the first and last word
+  outside the document are skipped, so no byte-wise pgm_read_byte() is
+  needed.
+
+  Strings without escapes are delivered with their flash address
+  (ElementValue::getStringSource()), so handlers of static lookup
+  documents can keep PROGMEM pointers instead of copying the text:
+
+    static const char table[] PROGMEM = "{\"names\":[\"alpha\",\"beta\"]}";
+    JsonFlashReader reader(table);
+    reader.pump(&parser);
+*/
+class JsonFlashReader {
+  private:
+    const char* data;
+    size_t length;
+    size_t position = 0;
+    uint32_t window[(JSON_FLASH_READER_WINDOW + 3) / 4];
+
+  public:
+    /*
+      Document of length bytes at data in flash.
+    */
+    JsonFlashReader(const char* data, size_t length);
+
+    /*
+      NUL-terminated document in flash.
+    */
+    JsonFlashReader(const char* data);
+
+    /*
+      Starts over at the first byte.
+    */
+    void rewind() { position = 0; }
+
+    size_t available() const { return length - position; }
+
+    bool isFinished() const { return position == length; }
+
+    /*
+      Bytes read so far, e.g. to report where an error happened.
+    */
+    size_t getPosition() const { return position; }
+
+    /*
+      Parses up to the end of the data. Stops at the end of the document
+      or at the first error, so several documents stored back to back are
+      parsed by calling it again. Returns the number of bytes consumed.
+    */
+    size_t pump(JsonStreamingParserBase* parser);
+};
+
+#endif // JSON_FLASH_READER_H
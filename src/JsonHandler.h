@@ -1,6 +1,3 @@
-#ifndef JSON_HANDLER_H
-#define JSON_HANDLER_H
-
 /**The MIT License (MIT)
 
 Copyright (c) 2015 by Daniel Eichhorn
@@ -56,6 +53,17 @@ class JsonHandler {
     virtual void value(ElementPath path, ElementValue value) = 0;
   
     virtual void whitespace(char c) = 0;
+
+    /*
+      Batches of consecutive numbers of an array registered with
+      JsonStreamingParserBase::addNumberBatch(): data[0] is element
+      firstIndex, which path points to.
+    */
+    virtual void values(ElementPath /* path */, const int32_t* /* data */, size_t /* count */, int /* firstIndex */) { }
+
+    virtual void values(ElementPath /* path */, const float* /* data */, size_t /* count */, int /* firstIndex */) { }
+
+    virtual void values(ElementPath /* path */, const double* /* data */, size_t /* count */, int /* firstIndex */) { }
 };
 
 #endif // JSON_HANDLER_H
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "JsonHttpBodyReader.h"
+
+enum JsonHttpBodyState : uint8_t {
+  BODY_DATA,
+  BODY_CHUNK_SIZE,
+  BODY_CHUNK_EXTENSION,
+  BODY_CHUNK_DATA,
+  BODY_CHUNK_DATA_END,
+  BODY_CHUNK_TRAILER,
+  BODY_DONE
+};
+
+JsonHttpBodyReader::JsonHttpBodyReader(JsonStreamingParserBase* parser) {
+  target = parser;
+  reset();
+}
+
+void JsonHttpBodyReader::setChunked(bool chunked) {
+  this->chunked = chunked;
+  reset();
+}
+
+void JsonHttpBodyReader::reset() {
+  state = chunked ? BODY_CHUNK_SIZE : BODY_DATA;
+  bodyCount = 0;
+  chunkRemaining = 0;
+  lineLength = 0;
+  hasError = false;
+  errorMessage = nullptr;
+}
+
+void JsonHttpBodyReader::fail(const char* message) {
+  hasError = true;
+  errorMessage = message;
+  state = BODY_DONE;
+}
+
+bool JsonHttpBodyReader::isDone() const {
+  return state == BODY_DONE || hasError || target->hasParseError() || target->isDocumentComplete();
+}
+
+/*
+  Hands a run of payload bytes to the parser.
+*/
+size_t JsonHttpBodyReader::parseData(const char* data, size_t length) {
+  size_t consumed = target->parse(data, length);
+  if (target->isDocumentComplete() || target->hasParseError()) {
+    state = BODY_DONE;
+  }
+  return consumed;
+}
+
+size_t JsonHttpBodyReader::write(const char* data, size_t length) {
+  size_t i = 0;
+  while (i < length && state != BODY_DONE) {
+    switch (state) {
+      case BODY_DATA: {
+        size_t run = length - i;
+        if (contentLength >= 0 && run > (uint32_t) contentLength - bodyCount) {
+          run = contentLength - bodyCount;
+        }
+        size_t consumed = parseData(data + i, run);
+        i += consumed;
+        bodyCount += consumed;
+        if (contentLength >= 0 && bodyCount >= (uint32_t) contentLength) {
+          state = BODY_DONE;
+        }
+      } continue;
+
+      case BODY_CHUNK_DATA: {
+        size_t run = length - i;
+        if (run > chunkRemaining) {
+          run = chunkRemaining;
+        }
+        size_t consumed = parseData(data + i, run);
+        i += consumed;
+        bodyCount += consumed;
+        chunkRemaining -= consumed;
+        if (chunkRemaining == 0 && state != BODY_DONE) {
+          state = BODY_CHUNK_DATA_END;
+        }
+      } continue;
+
+      default:
+        break;
+    }
+
+    // chunk framing, a byte at a time
+    char c = data[i++];
+    bodyCount++;
+    switch (state) {
+      case BODY_CHUNK_SIZE:
+        if (chunkRemaining > 0x0FFFFFF) {
+          fail("Invalid chunk size");
+        } else if (c >= '0' && c <= '9') {
+          chunkRemaining = (chunkRemaining << 4) | (c - '0');
+        } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+          chunkRemaining = (chunkRemaining << 4) | ((c | 0x20) - 'a' + 10);
+        } else if (c == ';' || c == ' ' || c == '\t') {
+          state = BODY_CHUNK_EXTENSION;
+        } else if (c == '\n') {
+          state = chunkRemaining > 0 ? BODY_CHUNK_DATA : BODY_CHUNK_TRAILER;
+        } else if (c != '\r') {
+          fail("Invalid chunk size");
+        }
+        break;
+      case BODY_CHUNK_EXTENSION:
+        if (c == '\n') {
+          state = chunkRemaining > 0 ? BODY_CHUNK_DATA : BODY_CHUNK_TRAILER;
+        }
+        break;
+      case BODY_CHUNK_DATA_END:
+        if (c == '\n') {
+          state = BODY_CHUNK_SIZE;
+        } else if (c != '\r') {
+          fail("Missing CRLF after chunk");
+        }
+        break;
+      case BODY_CHUNK_TRAILER:
+        // trailer fields, up to an empty line
+        if (c == '\n') {
+          if (lineLength == 0) {
+            state = BODY_DONE;
+          }
+          lineLength = 0;
+        } else if (c != '\r') {
+          lineLength++;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return i;
+}
+
+bool JsonHttpBodyReader::read(Client& client) {
+  uint32_t lastData = millis();
+  while (!isDone()) {
+#ifdef STREAMSEND_API
+    if (client.hasPeekBufferAPI()) {
+      size_t available = client.peekAvailable();
+      if (available > 0) {
+        // parse in place, releasing only what was consumed
+        client.peekConsume(write(client.peekBuffer(), available));
+        lastData = millis();
+        continue;
+      }
+    } else
+#endif
+    {
+      int available = client.available();
+      if (available > 0) {
+        char chunk[JSON_HTTP_BODY_READ_CHUNK];
+        size_t length = client.readBytes(chunk, available < (int) sizeof(chunk) ? available : sizeof(chunk));
+        write(chunk, length);
+        lastData = millis();
+        continue;
+      }
+    }
+
+    if (!client.connected()) {
+      break;
+    }
+    if (millis() - lastData > timeout) {
+      fail("Timeout reading HTTP body");
+      break;
+    }
+    delay(1);
+  }
+  return target->isDocumentComplete();
+}
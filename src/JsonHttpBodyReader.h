@@ -0,0 +1,98 @@
+#ifndef JSON_HTTP_BODY_READER_H
+#define JSON_HTTP_BODY_READER_H
+
+#include <Arduino.h>
+#include "Client.h"
+#include "JsonStreamingParser2.h"
+
+#define JSON_HTTP_BODY_READ_CHUNK  64
+
+/*
+  HTTP body front-end feeding a parser straight from the client, instead
+  of going through http.writeToStream() and its intermediate buffer.
+
+  On cores with the Stream peek buffer API (ESP8266 core 3+, where
+  STREAMSEND_API is defined), the parser reads directly out of the
+  client's receive buffer and only what it consumed is released; other
+  cores go through a small stack buffer. Chunked transfer encoding is
+  decoded inline. Reading stops as soon as the document is complete,
+  the parser reports an error, the body ends or the timeout expires, so
+  the rest of the transfer can be dropped right away.
+
+    http.begin(client, url);
+    const char* headers[] = { "Transfer-Encoding" };
+    http.collectHeaders(headers, 1);
+    if (http.GET() == HTTP_CODE_OK) {
+      JsonHttpBodyReader body(&parser);
+      body.setChunked(http.header("Transfer-Encoding") == "chunked");
+      body.setContentLength(http.getSize());
+      body.read(*http.getStreamPtr());
+    }
+    http.end();
+*/
+class JsonHttpBodyReader {
+  private:
+    JsonStreamingParserBase* target;
+    const char* errorMessage = nullptr;
+    int32_t contentLength = -1;
+    uint32_t bodyCount = 0;
+    uint32_t chunkRemaining = 0;
+    uint32_t timeout = 5000;
+    uint16_t lineLength = 0;
+    uint8_t state;
+    bool chunked = false;
+    bool hasError = false;
+
+    size_t parseData(const char* data, size_t length);
+
+    void fail(const char* message);
+
+  public:
+    JsonHttpBodyReader(JsonStreamingParserBase* parser);
+
+    /*
+      Body uses "Transfer-Encoding: chunked".
+    */
+    void setChunked(bool chunked);
+
+    /*
+      Body length from Content-Length, or -1 if unknown.
+    */
+    void setContentLength(int32_t length) { contentLength = length; }
+
+    /*
+      Milliseconds to wait for more data before giving up.
+    */
+    void setTimeout(uint32_t milliseconds) { timeout = milliseconds; }
+
+    /*
+      Reads and parses the body from client. Returns true if a complete
+      document was parsed.
+    */
+    bool read(Client& client);
+
+    /*
+      Decodes and parses body bytes received by other means. Returns the
+      number of bytes consumed, less than length once done.
+    */
+    size_t write(const char* data, size_t length);
+
+    void reset();
+
+    /*
+      True once nothing more needs to be read: the document is complete,
+      the body ended or an error occurred.
+    */
+    bool isDone() const;
+
+    bool isDocumentComplete() const { return target->isDocumentComplete(); }
+
+    // Error in the body's transfer encoding or in the parser
+    bool hasReadError() const { return hasError || target->hasParseError(); }
+    const char* getErrorMessage() const { return hasError ? errorMessage : target->getErrorMessage(); }
+
+    // Body bytes read so far, chunk framing included
+    uint32_t getBodyCount() const { return bodyCount; }
+};
+
+#endif // JSON_HTTP_BODY_READER_H
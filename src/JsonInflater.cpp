@@ -0,0 +1,665 @@
+#include "JsonInflater.h"
+
+enum JsonInflateState : uint8_t {
+  INFLATE_DETECT,
+  INFLATE_PASSTHROUGH,
+  INFLATE_GZIP_HEADER,
+  INFLATE_GZIP_EXTRA_LENGTH,
+  INFLATE_GZIP_EXTRA,
+  INFLATE_GZIP_NAME,
+  INFLATE_GZIP_COMMENT,
+  INFLATE_GZIP_HEADER_CRC,
+  INFLATE_ZLIB_HEADER,
+  INFLATE_BLOCK_HEADER,
+  INFLATE_STORED_LENGTH,
+  INFLATE_STORED,
+  INFLATE_DYNAMIC_COUNTS,
+  INFLATE_CODE_LENGTH_LENGTHS,
+  INFLATE_CODE_LENGTHS,
+  INFLATE_SYMBOL,
+  INFLATE_LENGTH_EXTRA,
+  INFLATE_DISTANCE,
+  INFLATE_DISTANCE_EXTRA,
+  INFLATE_COPY,
+  INFLATE_TRAILER,
+  INFLATE_DONE
+};
+
+#define GZIP_FLAG_HEADER_CRC  0x02
+#define GZIP_FLAG_EXTRA       0x04
+#define GZIP_FLAG_NAME        0x08
+#define GZIP_FLAG_COMMENT     0x10
+
+// RFC 1951 3.2.5: base values and extra bits of length and distance codes
+static const uint16_t lengthBase[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distanceBase[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distanceExtra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+// RFC 1951 3.2.7: order of the code length code lengths
+static const uint8_t codeLengthOrder[19] = {
+  16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+// CRC-32 (polynomial 0xEDB88320), 4 bits at a time
+static const uint32_t crcNibbles[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t updateCrc32(uint32_t crc, const uint8_t* data, size_t length) {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ crcNibbles[crc & 0x0F];
+    crc = (crc >> 4) ^ crcNibbles[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+static uint32_t updateAdler32(uint32_t adler, const uint8_t* data, size_t length) {
+  uint32_t a = adler & 0xFFFF;
+  uint32_t b = adler >> 16;
+  while (length > 0) {
+    // 5552 bytes cannot overflow the sums before the modulo
+    size_t run = length < 5552 ? length : 5552;
+    length -= run;
+    while (run-- > 0) {
+      a += *data++;
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+JsonInflater::JsonInflater(uint8_t* window, size_t windowSize, JsonStreamingParserBase* parser,
+                           JsonInflateFormat format) {
+  if (windowSize > JSON_INFLATE_MAX_WINDOW) {
+    windowSize = JSON_INFLATE_MAX_WINDOW;
+  }
+  this->window = window;
+  this->windowSize = windowSize;
+  this->target = parser;
+  this->format = format;
+  reset();
+}
+
+void JsonInflater::reset() {
+  bitBuffer = 0;
+  bitCount = 0;
+  totalIn = 0;
+  totalOut = 0;
+  windowPos = 0;
+  flushedPos = 0;
+  remaining = 0;
+  trailer = 0;
+  finalBlock = false;
+  hasError = false;
+  errorMessage = nullptr;
+  detected = format;
+  switch (format) {
+    case JSON_INFLATE_GZIP:
+      state = INFLATE_GZIP_HEADER;
+      break;
+    case JSON_INFLATE_ZLIB:
+      state = INFLATE_ZLIB_HEADER;
+      break;
+    case JSON_INFLATE_RAW:
+      state = INFLATE_BLOCK_HEADER;
+      break;
+    default:
+      state = INFLATE_DETECT;
+      break;
+  }
+  checksum = detected == JSON_INFLATE_ZLIB ? 1 : 0;
+  if (windowSize == 0) {
+    // output() needs room for at least one byte before it wraps
+    fail("The inflate window is empty");
+  }
+}
+
+bool JsonInflater::isDone() const {
+  return state == INFLATE_DONE;
+}
+
+void JsonInflater::fail(const char* message) {
+  hasError = true;
+  errorMessage = message;
+}
+
+size_t JsonInflater::write(const uint8_t* data, size_t length) {
+  if (hasError) {
+    return 0;
+  }
+  input = data;
+  inputEnd = data + length;
+  while (!hasError && step()) {
+  }
+  totalIn += length - (inputEnd - input);
+  flush();
+  input = inputEnd = nullptr;
+  return hasError ? 0 : length;
+}
+
+bool JsonInflater::needBits(uint8_t count) {
+  while (bitCount < count) {
+    if (input == inputEnd) {
+      return false;
+    }
+    bitBuffer |= (uint32_t) *input++ << bitCount;
+    bitCount += 8;
+  }
+  return true;
+}
+
+uint32_t JsonInflater::takeBits(uint8_t count) {
+  uint32_t value = bitBuffer & ((1UL << count) - 1);
+  bitBuffer >>= count;
+  bitCount -= count;
+  return value;
+}
+
+bool JsonInflater::takeByte(uint8_t& value) {
+  if (!needBits(8)) {
+    return false;
+  }
+  value = takeBits(8);
+  return true;
+}
+
+void JsonInflater::alignToByte() {
+  takeBits(bitCount & 7);
+}
+
+/*
+  Decodes the next symbol without consuming it. Returns -1 if more input
+  is needed, -2 for an invalid code.
+*/
+int JsonInflater::peekSymbol(const uint16_t* counts, const uint16_t* symbols, uint8_t& length) {
+  // pull in as much as the longest code could need, if available
+  needBits(15);
+  int code = 0;
+  int first = 0;
+  int index = 0;
+  for (uint8_t len = 1; len <= 15; len++) {
+    if (len > bitCount) {
+      return -1;
+    }
+    code |= (bitBuffer >> (len - 1)) & 1;
+    int count = counts[len];
+    if (code - first < count) {
+      length = len;
+      return symbols[index + code - first];
+    }
+    index += count;
+    first = (first + count) << 1;
+    code <<= 1;
+  }
+  return -2;
+}
+
+bool JsonInflater::buildTable(uint16_t* counts, uint16_t* symbols, const uint8_t* codeLengths, int count) {
+  uint16_t offsets[16];
+  memset(counts, 0, 16 * sizeof(uint16_t));
+  for (int i = 0; i < count; i++) {
+    counts[codeLengths[i]]++;
+  }
+  counts[0] = 0;
+  // over-subscribed codes are invalid (incomplete ones are allowed)
+  int left = 1;
+  for (int len = 1; len < 16; len++) {
+    left = (left << 1) - counts[len];
+    if (left < 0) {
+      return false;
+    }
+  }
+  offsets[1] = 0;
+  for (int len = 1; len < 15; len++) {
+    offsets[len + 1] = offsets[len] + counts[len];
+  }
+  for (int i = 0; i < count; i++) {
+    if (codeLengths[i] != 0) {
+      symbols[offsets[codeLengths[i]]++] = i;
+    }
+  }
+  return true;
+}
+
+void JsonInflater::buildFixedTables() {
+  int i = 0;
+  for (; i < 144; i++) lengths[i] = 8;
+  for (; i < 256; i++) lengths[i] = 9;
+  for (; i < 280; i++) lengths[i] = 7;
+  for (; i < 288; i++) lengths[i] = 8;
+  buildTable(literalCounts, literalSymbols, lengths, 288);
+  for (i = 0; i < 30; i++) lengths[i] = 5;
+  buildTable(distanceCounts, distanceSymbols, lengths, 30);
+}
+
+void JsonInflater::output(uint8_t value) {
+  window[windowPos++] = value;
+  totalOut++;
+  if (windowPos == windowSize) {
+    flush();
+    windowPos = 0;
+    flushedPos = 0;
+  }
+}
+
+/*
+  Hands what was decoded since the last flush to the parser.
+*/
+void JsonInflater::flush() {
+  if (windowPos == flushedPos) {
+    return;
+  }
+  const uint8_t* data = window + flushedPos;
+  size_t length = windowPos - flushedPos;
+  flushedPos = windowPos;
+  if (detected == JSON_INFLATE_GZIP) {
+    checksum = updateCrc32(checksum, data, length);
+  } else if (detected == JSON_INFLATE_ZLIB) {
+    checksum = updateAdler32(checksum, data, length);
+  }
+  if (target != nullptr) {
+    // whatever follows the end of a document goes to the parser too
+    size_t consumed = 0;
+    while (consumed < length && !target->hasParseError()) {
+      consumed += target->parse((const char*) data + consumed, length - consumed);
+    }
+    if (target->hasParseError()) {
+      fail(target->getErrorMessage());
+    }
+  }
+}
+
+/*
+  Runs one step of the decoder. Returns false when more input is needed
+  (or the stream is done).
+*/
+bool JsonInflater::step() {
+  uint8_t value;
+  switch (state) {
+    case INFLATE_DETECT:
+      if (input == inputEnd) {
+        return false;
+      }
+      if (remaining == 0) {
+        firstByte = *input++;
+        remaining = 1;
+        return true;
+      }
+      remaining = 0;
+      if (firstByte == 0x1F && *input == 0x8B) {
+        detected = JSON_INFLATE_GZIP;
+        checksum = 0;
+        // the magic was just checked
+        input++;
+        remaining = 2;
+        state = INFLATE_GZIP_HEADER;
+      } else if ((firstByte & 0x0F) == 8 && (firstByte >> 4) <= 7 && ((firstByte << 8) | *input) % 31 == 0
+                 && !(*input & 0x20)) {
+        // with FDICT set it is taken for text: "80..." has a valid check
+        detected = JSON_INFLATE_ZLIB;
+        checksum = 1;
+        input++;
+        state = INFLATE_BLOCK_HEADER;
+      } else {
+        // not compressed after all
+        state = INFLATE_PASSTHROUGH;
+        output(firstByte);
+      }
+      return true;
+
+    case INFLATE_PASSTHROUGH:
+      while (input != inputEnd && !hasError) {
+        output(*input++);
+      }
+      return false;
+
+    case INFLATE_GZIP_HEADER:
+      // magic (2), method, flags, time (4), extra flags, OS
+      if (!takeByte(value)) {
+        return false;
+      }
+      if ((remaining == 0 && value != 0x1F) || (remaining == 1 && value != 0x8B)
+          || (remaining == 2 && value != 8)) {
+        fail("Invalid gzip header");
+        return false;
+      }
+      if (remaining == 3) {
+        headerFlags = value;
+      }
+      if (++remaining == 10) {
+        remaining = 0;
+        state = INFLATE_GZIP_EXTRA_LENGTH;
+      }
+      return true;
+
+    case INFLATE_GZIP_EXTRA_LENGTH:
+      if (!(headerFlags & GZIP_FLAG_EXTRA)) {
+        state = INFLATE_GZIP_NAME;
+        return true;
+      }
+      if (!needBits(16)) {
+        return false;
+      }
+      remaining = takeBits(16);
+      state = INFLATE_GZIP_EXTRA;
+      return true;
+
+    case INFLATE_GZIP_EXTRA:
+      if (remaining > 0) {
+        if (!takeByte(value)) {
+          return false;
+        }
+        remaining--;
+        return true;
+      }
+      state = INFLATE_GZIP_NAME;
+      return true;
+
+    case INFLATE_GZIP_NAME:
+    case INFLATE_GZIP_COMMENT: {
+      uint8_t flag = state == INFLATE_GZIP_NAME ? GZIP_FLAG_NAME : GZIP_FLAG_COMMENT;
+      if (headerFlags & flag) {
+        // zero terminated
+        if (!takeByte(value)) {
+          return false;
+        }
+        if (value != 0) {
+          return true;
+        }
+      }
+      state = state == INFLATE_GZIP_NAME ? INFLATE_GZIP_COMMENT : INFLATE_GZIP_HEADER_CRC;
+      return true;
+    }
+
+    case INFLATE_GZIP_HEADER_CRC:
+      if (headerFlags & GZIP_FLAG_HEADER_CRC) {
+        if (!needBits(16)) {
+          return false;
+        }
+        takeBits(16);
+      }
+      state = INFLATE_BLOCK_HEADER;
+      return true;
+
+    case INFLATE_ZLIB_HEADER:
+      if (!needBits(16)) {
+        return false;
+      }
+      {
+        uint8_t method = takeBits(8);
+        uint8_t flags = takeBits(8);
+        if ((method & 0x0F) != 8 || ((method << 8) | flags) % 31 != 0) {
+          fail("Invalid zlib header");
+          return false;
+        }
+        if (flags & 0x20) {
+          fail("zlib preset dictionaries are not supported");
+          return false;
+        }
+      }
+      state = INFLATE_BLOCK_HEADER;
+      return true;
+
+    case INFLATE_BLOCK_HEADER:
+      if (finalBlock) {
+        alignToByte();
+        remaining = 0;
+        state = detected == JSON_INFLATE_RAW ? INFLATE_DONE : INFLATE_TRAILER;
+        return true;
+      }
+      if (!needBits(3)) {
+        return false;
+      }
+      finalBlock = takeBits(1);
+      switch (takeBits(2)) {
+        case 0:
+          alignToByte();
+          state = INFLATE_STORED_LENGTH;
+          break;
+        case 1:
+          buildFixedTables();
+          state = INFLATE_SYMBOL;
+          break;
+        case 2:
+          state = INFLATE_DYNAMIC_COUNTS;
+          break;
+        default:
+          fail("Invalid deflate block type");
+          return false;
+      }
+      return true;
+
+    case INFLATE_STORED_LENGTH:
+      if (!needBits(32)) {
+        return false;
+      }
+      remaining = takeBits(16);
+      if ((uint16_t) ~takeBits(16) != remaining) {
+        fail("Invalid stored block length");
+        return false;
+      }
+      state = INFLATE_STORED;
+      return true;
+
+    case INFLATE_STORED:
+      while (remaining > 0) {
+        if (!takeByte(value)) {
+          return false;
+        }
+        output(value);
+        remaining--;
+      }
+      state = INFLATE_BLOCK_HEADER;
+      return true;
+
+    case INFLATE_DYNAMIC_COUNTS:
+      if (!needBits(14)) {
+        return false;
+      }
+      literalCount = takeBits(5) + 257;
+      distanceCount = takeBits(5) + 1;
+      codeLengthCount = takeBits(4) + 4;
+      if (literalCount > 286 || distanceCount > 30) {
+        fail("Invalid deflate code counts");
+        return false;
+      }
+      memset(lengths, 0, 19);
+      remaining = 0;
+      state = INFLATE_CODE_LENGTH_LENGTHS;
+      return true;
+
+    case INFLATE_CODE_LENGTH_LENGTHS:
+      while (remaining < codeLengthCount) {
+        if (!needBits(3)) {
+          return false;
+        }
+        lengths[codeLengthOrder[remaining++]] = takeBits(3);
+      }
+      // the code length code lives in the distance table until the real
+      // one is built
+      if (!buildTable(distanceCounts, distanceSymbols, lengths, 19)) {
+        fail("Invalid deflate code length code");
+        return false;
+      }
+      lengthCount = 0;
+      state = INFLATE_CODE_LENGTHS;
+      return true;
+
+    case INFLATE_CODE_LENGTHS:
+      while (lengthCount < literalCount + distanceCount) {
+        uint8_t codeLength;
+        int symbol = peekSymbol(distanceCounts, distanceSymbols, codeLength);
+        if (symbol == -1) {
+          return false;
+        }
+        if (symbol < 0) {
+          fail("Invalid deflate code length");
+          return false;
+        }
+        if (symbol < 16) {
+          takeBits(codeLength);
+          lengths[lengthCount++] = symbol;
+          continue;
+        }
+        // repeat codes: symbol and extra bits are taken together
+        uint8_t extraBits = symbol == 16 ? 2 : symbol == 17 ? 3 : 7;
+        if (!needBits(codeLength + extraBits)) {
+          return false;
+        }
+        takeBits(codeLength);
+        uint8_t repeated = 0;
+        int repeat;
+        if (symbol == 16) {
+          if (lengthCount == 0) {
+            fail("Invalid deflate code length repeat");
+            return false;
+          }
+          repeated = lengths[lengthCount - 1];
+          repeat = 3 + takeBits(2);
+        } else if (symbol == 17) {
+          repeat = 3 + takeBits(3);
+        } else {
+          repeat = 11 + takeBits(7);
+        }
+        if (lengthCount + repeat > literalCount + distanceCount) {
+          fail("Invalid deflate code length repeat");
+          return false;
+        }
+        while (repeat-- > 0) {
+          lengths[lengthCount++] = repeated;
+        }
+      }
+      if (lengths[256] == 0
+          || !buildTable(literalCounts, literalSymbols, lengths, literalCount)
+          || !buildTable(distanceCounts, distanceSymbols, lengths + literalCount, distanceCount)) {
+        fail("Invalid deflate codes");
+        return false;
+      }
+      state = INFLATE_SYMBOL;
+      return true;
+
+    case INFLATE_SYMBOL: {
+      uint8_t codeLength;
+      int symbol = peekSymbol(literalCounts, literalSymbols, codeLength);
+      if (symbol == -1) {
+        return false;
+      }
+      if (symbol < 0 || symbol > 285) {
+        fail("Invalid deflate literal/length code");
+        return false;
+      }
+      takeBits(codeLength);
+      if (symbol < 256) {
+        output(symbol);
+      } else if (symbol == 256) {
+        state = INFLATE_BLOCK_HEADER;
+      } else {
+        remaining = symbol - 257;
+        state = INFLATE_LENGTH_EXTRA;
+      }
+      return true;
+    }
+
+    case INFLATE_LENGTH_EXTRA:
+      if (!needBits(lengthExtra[remaining])) {
+        return false;
+      }
+      copyLength = lengthBase[remaining] + takeBits(lengthExtra[remaining]);
+      state = INFLATE_DISTANCE;
+      return true;
+
+    case INFLATE_DISTANCE: {
+      uint8_t codeLength;
+      int symbol = peekSymbol(distanceCounts, distanceSymbols, codeLength);
+      if (symbol == -1) {
+        return false;
+      }
+      if (symbol < 0 || symbol > 29) {
+        fail("Invalid deflate distance code");
+        return false;
+      }
+      takeBits(codeLength);
+      remaining = symbol;
+      state = INFLATE_DISTANCE_EXTRA;
+      return true;
+    }
+
+    case INFLATE_DISTANCE_EXTRA: {
+      if (!needBits(distanceExtra[remaining])) {
+        return false;
+      }
+      uint32_t distance = distanceBase[remaining] + takeBits(distanceExtra[remaining]);
+      if (distance > totalOut || distance > windowSize) {
+        fail("Deflate distance beyond the inflate window");
+        return false;
+      }
+      remaining = distance;
+      state = INFLATE_COPY;
+      return true;
+    }
+
+    case INFLATE_COPY: {
+      // needs no input, so it runs to completion
+      uint16_t from = windowPos >= remaining ? windowPos - remaining : windowPos + windowSize - remaining;
+      while (copyLength > 0 && !hasError) {
+        output(window[from]);
+        if (++from == windowSize) {
+          from = 0;
+        }
+        copyLength--;
+      }
+      state = INFLATE_SYMBOL;
+      return true;
+    }
+
+    case INFLATE_TRAILER: {
+      // gzip: CRC-32 and size, little endian; zlib: Adler-32, big endian
+      uint8_t trailerSize = detected == JSON_INFLATE_GZIP ? 8 : 4;
+      while (remaining < trailerSize) {
+        if (!takeByte(value)) {
+          return false;
+        }
+        if (detected == JSON_INFLATE_GZIP) {
+          trailer |= (uint32_t) value << (8 * (remaining & 3));
+        } else {
+          trailer = (trailer << 8) | value;
+        }
+        remaining++;
+        if (remaining == 4 || remaining == 8) {
+          // the decoded output must be complete before checking it
+          flush();
+          uint32_t expected = remaining == 4 ? checksum : totalOut;
+          if (trailer != expected) {
+            fail(remaining == 4 ? "Compressed data checksum mismatch" : "Compressed data length mismatch");
+            return false;
+          }
+          trailer = 0;
+        }
+      }
+      state = INFLATE_DONE;
+      return true;
+    }
+
+    default:
+      // trailing bytes after the end are ignored
+      input = inputEnd;
+      return false;
+  }
+}
@@ -0,0 +1,169 @@
+#ifndef JSON_INFLATER_H
+#define JSON_INFLATER_H
+
+#include <Arduino.h>
+#include "ArduinoStreamParser.h"
+
+#define JSON_INFLATE_MAX_WINDOW  32768
+
+enum JsonInflateFormat : uint8_t {
+  // gzip or zlib according to the first bytes, anything else is passed
+  // through as is (a server may ignore Accept-Encoding)
+  JSON_INFLATE_AUTO = 0,
+  JSON_INFLATE_GZIP = 1,
+  JSON_INFLATE_ZLIB = 2,
+  JSON_INFLATE_RAW  = 3
+};
+
+/*
+  Streaming deflate decoder (RFC 1951, with the gzip and zlib wrappers of
+  RFC 1952/1950) feeding a parser.
+
+  Compressed bytes are pushed in arbitrary chunks with write(); decoding
+  stops whenever a chunk is used up and carries on with the next one, so
+  the payload is never held in memory. Decompressed bytes go through a
+  caller-provided window of 1 to 32 KB and are handed to the parser's
+  bulk input in runs as the window fills up.
+
+  Deflate back-references reach up to 32 KB back. Servers usually
+  compress with the full window, but most JSON repeats itself over short
+  distances, so smaller windows tend to work; a reference beyond the
+  window is reported as an error.
+
+  Besides the window, the decoder needs about 1.1 KB for its Huffman
+  tables.
+*/
+class JsonInflater {
+  private:
+    JsonStreamingParserBase* target;
+    uint8_t* window;
+
+    const uint8_t* input = nullptr;
+    const uint8_t* inputEnd = nullptr;
+
+    const char* errorMessage = nullptr;
+
+    uint32_t bitBuffer = 0;
+    uint32_t totalIn = 0;
+    uint32_t totalOut = 0;
+    // CRC-32 (gzip) or Adler-32 (zlib) of the output
+    uint32_t checksum = 0;
+    uint32_t trailer = 0;
+
+    uint16_t windowSize;
+    uint16_t windowPos = 0;
+    uint16_t flushedPos = 0;
+
+    // state specific counters
+    uint16_t remaining = 0;
+    uint16_t copyLength = 0;
+    uint16_t lengthCount = 0;
+    uint16_t literalCount = 0;
+    uint8_t distanceCount = 0;
+    uint8_t codeLengthCount = 0;
+    uint8_t headerFlags = 0;
+    uint8_t firstByte = 0;
+
+    uint8_t state;
+    uint8_t bitCount = 0;
+    JsonInflateFormat format;
+    JsonInflateFormat detected;
+    bool finalBlock = false;
+    bool hasError = false;
+
+    // canonical Huffman codes: number of codes per length, and symbols
+    // ordered by code
+    uint16_t literalCounts[16];
+    uint16_t literalSymbols[288];
+    uint16_t distanceCounts[16];
+    uint16_t distanceSymbols[32];
+    // code lengths of a dynamic block being read
+    uint8_t lengths[288 + 32];
+
+    bool step();
+
+    bool needBits(uint8_t count);
+    uint32_t takeBits(uint8_t count);
+    bool takeByte(uint8_t& value);
+    void alignToByte();
+
+    int peekSymbol(const uint16_t* counts, const uint16_t* symbols, uint8_t& length);
+    bool buildTable(uint16_t* counts, uint16_t* symbols, const uint8_t* codeLengths, int count);
+    void buildFixedTables();
+
+    void output(uint8_t value);
+    void flush();
+
+    void fail(const char* message);
+
+  public:
+    /*
+      Builds a decoder writing through window (windowSize bytes, at most
+      32 KB) into parser. An empty window fails every write.
+    */
+    JsonInflater(uint8_t* window, size_t windowSize, JsonStreamingParserBase* parser,
+                 JsonInflateFormat format = JSON_INFLATE_AUTO);
+
+    /*
+      Decodes a chunk of compressed input. Returns length, or 0 once an
+      error occurred (in the compressed data or in the parser).
+    */
+    size_t write(const uint8_t* data, size_t length);
+
+    void reset();
+
+    /*
+      True once the end of the compressed stream (and its checksum) has
+      been read.
+    */
+    bool isDone() const;
+
+    bool hasInflateError() const { return hasError; }
+    const char* getErrorMessage() const { return errorMessage; }
+
+    uint32_t getInputCount() const { return totalIn; }
+    uint32_t getOutputCount() const { return totalOut; }
+};
+
+/*
+  Stream front-end, e.g. http.writeToStream(&inflateStream) with an
+  "Accept-Encoding: gzip" request header.
+*/
+class JsonInflateStream: public Stream {
+  private:
+    JsonInflater* inflater;
+
+  public:
+    JsonInflateStream(JsonInflater* inflater) : inflater(inflater) { }
+
+    void clear() { inflater->reset(); }
+
+    virtual size_t write(uint8_t data) { return inflater->write(&data, 1); }
+    virtual size_t write(const uint8_t* buffer, size_t size) { return inflater->write(buffer, size); }
+
+    virtual int available() { return 1; }
+    virtual int read() { return 0; }
+    virtual int peek() { return 0; }
+    virtual void flush() { }
+
+    virtual int availableForWrite() { return CHARS_TO_PARSE_EACH_TIME; }
+    virtual bool outputCanTimeout() { return false; }
+};
+
+/*
+  Stream front-end with an embedded decoder and window.
+*/
+template <size_t WINDOW_SIZE>
+class StaticJsonInflateStream: public JsonInflateStream {
+  private:
+    uint8_t windowStorage[WINDOW_SIZE];
+    JsonInflater decoder;
+
+  public:
+    StaticJsonInflateStream(JsonStreamingParserBase* parser, JsonInflateFormat format = JSON_INFLATE_AUTO)
+      : JsonInflateStream(&decoder), decoder(windowStorage, WINDOW_SIZE, parser, format) { }
+
+    JsonInflater& getInflater() { return decoder; }
+};
+
+#endif // JSON_INFLATER_H
@@ -0,0 +1,176 @@
+#include "JsonMinifier.h"
+#include "JsonDigits.h"
+
+enum JsonMinifyClass : uint8_t {
+  // copied as part of a run: numbers, literals and anything else
+  MINIFY_COPY = 0,
+  MINIFY_SPACE,
+  MINIFY_QUOTE,
+  MINIFY_OPEN,
+  MINIFY_CLOSE,
+  MINIFY_COMMA,
+  MINIFY_COLON
+};
+
+// JsonMinifier::pending
+#define MINIFY_PENDING_NONE      0
+#define MINIFY_PENDING_INDENT    1
+#define MINIFY_PENDING_DOCUMENT  2
+
+constexpr uint8_t jsonMinifyClass(int c) {
+  return (c == ' ' || c == '\t' || c == '\n' || c == '\r') ? MINIFY_SPACE
+       : c == '"' ? MINIFY_QUOTE
+       : (c == '{' || c == '[') ? MINIFY_OPEN
+       : (c == '}' || c == ']') ? MINIFY_CLOSE
+       : c == ',' ? MINIFY_COMMA
+       : c == ':' ? MINIFY_COLON
+       : MINIFY_COPY;
+}
+
+#define JSON_MINIFY_CLASS_4(c)   jsonMinifyClass(c), jsonMinifyClass(c + 1), jsonMinifyClass(c + 2), jsonMinifyClass(c + 3)
+#define JSON_MINIFY_CLASS_16(c)  JSON_MINIFY_CLASS_4(c), JSON_MINIFY_CLASS_4(c + 4), JSON_MINIFY_CLASS_4(c + 8), JSON_MINIFY_CLASS_4(c + 12)
+#define JSON_MINIFY_CLASS_64(c)  JSON_MINIFY_CLASS_16(c), JSON_MINIFY_CLASS_16(c + 16), JSON_MINIFY_CLASS_16(c + 32), JSON_MINIFY_CLASS_16(c + 48)
+
+static constexpr uint8_t minifyClasses[256] = {
+  JSON_MINIFY_CLASS_64(0), JSON_MINIFY_CLASS_64(64), JSON_MINIFY_CLASS_64(128), JSON_MINIFY_CLASS_64(192)
+};
+
+JsonMinifier::JsonMinifier(JsonSink* sink, int indent) {
+  this->sink = sink;
+  setIndent(indent);
+}
+
+void JsonMinifier::reset() {
+  depth = 0;
+  pending = MINIFY_PENDING_NONE;
+  inString = false;
+  escape = false;
+}
+
+void JsonMinifier::newLine(uint16_t level) {
+  static const char spaces[] = "                ";
+  sink->write('\n');
+  for (uint32_t count = (uint32_t) level * indent; count > 0; ) {
+    uint32_t run = count < sizeof(spaces) - 1 ? count : sizeof(spaces) - 1;
+    sink->write(spaces, run);
+    count -= run;
+  }
+}
+
+void JsonMinifier::beginToken() {
+  if (pending == MINIFY_PENDING_INDENT) {
+    newLine(depth);
+  } else {
+    sink->write('\n');
+  }
+  pending = MINIFY_PENDING_NONE;
+}
+
+/*
+  Copies string bytes up to and including the closing quote, or to the
+  end of the input if the string goes on. Returns where it stopped.
+*/
+size_t JsonMinifier::copyString(const char* data, size_t i, size_t length) {
+  size_t start = i;
+  while (i < length) {
+    if (escape) {
+      escape = false;
+      i++;
+      continue;
+    }
+#if JSON_PARSER_SWAR
+    while (length - i >= 8 && jsonIsEightStringBytes(jsonLoadEightBytes(data + i))) {
+      i += 8;
+    }
+    if (i == length) {
+      break;
+    }
+#endif
+    char c = data[i++];
+    if (c == '\\') {
+      escape = true;
+    } else if (c == '"') {
+      inString = false;
+      break;
+    }
+  }
+  sink->write(data + start, i - start);
+  return i;
+}
+
+size_t JsonMinifier::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t JsonMinifier::write(const uint8_t *buffer, size_t size) {
+  const char* data = (const char*) buffer;
+  size_t i = 0;
+  while (i < size) {
+    if (inString) {
+      i = copyString(data, i, size);
+      continue;
+    }
+    // numbers and literals go out as one run
+    size_t start = i;
+    while (i < size && minifyClasses[(uint8_t) data[i]] == MINIFY_COPY) {
+      i++;
+    }
+    if (i > start) {
+      if (pending != MINIFY_PENDING_NONE) {
+        beginToken();
+      }
+      sink->write(data + start, i - start);
+      if (i == size) {
+        break;
+      }
+    }
+    char c = data[i++];
+    switch (minifyClasses[(uint8_t) c]) {
+    case MINIFY_SPACE:
+      break;
+    case MINIFY_QUOTE:
+      if (pending != MINIFY_PENDING_NONE) {
+        beginToken();
+      }
+      sink->write(c);
+      inString = true;
+      break;
+    case MINIFY_OPEN:
+      if (pending != MINIFY_PENDING_NONE) {
+        beginToken();
+      }
+      sink->write(c);
+      depth++;
+      if (indent > 0) {
+        pending = MINIFY_PENDING_INDENT;
+      }
+      break;
+    case MINIFY_CLOSE:
+      if (pending == MINIFY_PENDING_INDENT) {
+        // empty container
+        pending = MINIFY_PENDING_NONE;
+      } else if (indent > 0 && depth > 0) {
+        newLine(depth - 1);
+      }
+      sink->write(c);
+      if (depth > 0 && --depth == 0) {
+        pending = MINIFY_PENDING_DOCUMENT;
+      }
+      break;
+    case MINIFY_COMMA:
+      sink->write(c);
+      if (indent > 0) {
+        newLine(depth);
+      }
+      break;
+    case MINIFY_COLON:
+      if (indent > 0) {
+        sink->write(": ", 2);
+      } else {
+        sink->write(c);
+      }
+      break;
+    }
+  }
+  return sink->hasOverflowed() ? 0 : size;
+}
@@ -0,0 +1,71 @@
+#ifndef JSON_MINIFIER_H
+#define JSON_MINIFIER_H
+
+#include "Stream.h"
+#include <Arduino.h>
+#include "JsonSink.h"
+
+/*
+  Streaming minifier: rewrites JSON passing through it into a JsonSink
+  without the whitespace between tokens, or re-indented with the given
+  number of spaces per level (setIndent). Strings and numbers are copied
+  byte for byte, escapes included, and runs of bytes that need no
+  attention go to the sink in one write, so minifying costs little more
+  than a copy.
+
+  It only tracks strings and nesting, without checking the syntax:
+  validate untrusted input (JsonStreamingParserBase::validate) as well.
+  Consecutive documents are separated by a newline.
+
+  Being a Stream, it can be filled by http.writeToStream(&minifier):
+
+    JsonSink sink(&file, chunk, sizeof(chunk));
+    JsonMinifier minifier(&sink);
+    http.writeToStream(&minifier);
+    minifier.flush();
+*/
+class JsonMinifier: public Stream {
+  private:
+    JsonSink* sink;
+
+    uint16_t depth = 0;
+    uint8_t indent = 0;
+    // line break owed before the next token: after an opening bracket
+    // (unless the container is empty) or between documents
+    uint8_t pending = 0;
+    bool inString = false;
+    bool escape = false;
+
+    size_t copyString(const char* data, size_t i, size_t length);
+
+    void beginToken();
+
+    void newLine(uint16_t level);
+
+  public:
+    JsonMinifier(JsonSink* sink, int indent = 0);
+
+    /*
+      Spaces per nesting level, 0 to minify.
+    */
+    void setIndent(int indent) { this->indent = indent < 16 ? indent : 16; }
+
+    /*
+      Forgets an unfinished document.
+    */
+    void reset();
+
+    int getDepth() const { return depth; }
+
+    bool hasWriteError() const { return sink->hasOverflowed(); }
+
+    virtual size_t write(uint8_t c);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    virtual void flush() { sink->flush(); }
+};
+
+#endif // JSON_MINIFIER_H
@@ -0,0 +1,69 @@
+#ifndef JSON_NUMBER_BATCH_H
+#define JSON_NUMBER_BATCH_H
+
+#include <Arduino.h>
+
+enum JsonNumberBatchType : uint8_t {
+  JSON_BATCH_INT32   = 0,
+  JSON_BATCH_FLOAT   = 1,
+  JSON_BATCH_DOUBLE  = 2,
+  // int32_t in units of 10^-scale
+  JSON_BATCH_FIXED   = 3
+};
+
+/*
+  Caller-provided array collecting the numbers of the arrays at a given
+  normalized path (see JsonPathHash.h), e.g.
+
+    float history[64];
+    JsonNumberBatch historyBatch(jsonPathHash("sensors[].history[]"), history, 64);
+    parser.addNumberBatch(&historyBatch);
+
+  Consecutive numbers of matching arrays are converted straight into
+  data and handed to JsonHandler::values() whenever it is full, before
+  any other element and at the end of the array, instead of one value()
+  call each. int32_t batches only take integers; numbers with a fraction
+  or an exponent are reported through value() as usual.
+
+  Fixed-point batches take all numbers as int32_t in units of 10^-scale
+  (clamped to the int32_t range), converted with integer arithmetic
+  only, for cores without an FPU:
+
+    int32_t centis[64];   // 21.57 -> 2157
+    JsonNumberBatch tempBatch(jsonPathHash("hourly[].temp"), centis, 64, 2);
+*/
+class JsonNumberBatch {
+  friend class JsonStreamingParserBase;
+
+  private:
+    JsonNumberBatch* next = nullptr;
+    void* data;
+    uint32_t pathHash;
+    int firstIndex = 0;
+    uint16_t capacity;
+    uint16_t count = 0;
+    JsonNumberBatchType type;
+    int8_t scale = 0;
+
+  public:
+    JsonNumberBatch(uint32_t pathHash, int32_t* data, size_t capacity)
+      : data(data), pathHash(pathHash), capacity(capacity < 65535 ? capacity : 65535), type(JSON_BATCH_INT32) { }
+
+    JsonNumberBatch(uint32_t pathHash, int32_t* data, size_t capacity, int scale)
+      : data(data), pathHash(pathHash), capacity(capacity < 65535 ? capacity : 65535), type(JSON_BATCH_FIXED),
+        scale(scale) { }
+
+    JsonNumberBatch(uint32_t pathHash, float* data, size_t capacity)
+      : data(data), pathHash(pathHash), capacity(capacity < 65535 ? capacity : 65535), type(JSON_BATCH_FLOAT) { }
+
+    JsonNumberBatch(uint32_t pathHash, double* data, size_t capacity)
+      : data(data), pathHash(pathHash), capacity(capacity < 65535 ? capacity : 65535), type(JSON_BATCH_DOUBLE) { }
+
+    JsonNumberBatchType getType() const { return type; }
+    int getScale() const { return scale; }
+
+    // Values collected but not delivered yet
+    size_t getCount() const { return count; }
+};
+
+#endif // JSON_NUMBER_BATCH_H
@@ -0,0 +1,57 @@
+#ifndef JSON_PARSER_BUDGET_H
+#define JSON_PARSER_BUDGET_H
+
+#include <Arduino.h>
+
+// Bytes parsed between two checks of the time budget
+#ifndef JSON_PARSER_BUDGET_INTERVAL
+#define JSON_PARSER_BUDGET_INTERVAL  512
+#endif
+
+/*
+  Runtime limits for each document a parser takes in, on top of the
+  compile-time buffer and stack sizes, against upstreams sending huge or
+  pathological bodies:
+
+    JsonParserBudget budget;
+    budget.maxBytes = 64 * 1024;
+    budget.maxEvents = 5000;      // values, keys, starts and ends
+    budget.maxDepth = 12;
+    budget.maxStringLength = 200; // strings, keys and numbers
+    budget.maxMillis = 50;
+    parser.setBudget(&budget);
+
+  Exceeding one aborts the parse with its own error code
+  (JsonStreamingParserBase::getErrorCode()). 0 means no limit. Usage is
+  counted from the first byte of each document; the elapsed time is
+  checked every JSON_PARSER_BUDGET_INTERVAL bytes, so a budgeted parse
+  calls millis() only that often.
+*/
+class JsonParserBudget {
+  friend class JsonStreamingParserBase;
+
+  private:
+    uint32_t events = 0;
+    uint32_t startMillis = 0;
+    // byte count at which the time is checked next
+    uint32_t nextCheck = 0;
+
+    void start(uint32_t position) {
+      events = 0;
+      startMillis = millis();
+      nextCheck = position + JSON_PARSER_BUDGET_INTERVAL;
+    }
+
+  public:
+    uint32_t maxBytes = 0;
+    uint32_t maxEvents = 0;
+    uint32_t maxMillis = 0;
+    uint16_t maxStringLength = 0;
+    uint8_t maxDepth = 0;
+
+    // Usage of the current (or last) document
+    uint32_t getEventCount() const { return events; }
+    uint32_t getStartMillis() const { return startMillis; }
+};
+
+#endif // JSON_PARSER_BUDGET_H
@@ -0,0 +1,37 @@
+#include "JsonParserStats.h"
+
+#ifdef JSON_PARSER_STATS
+
+static const char* const stateNames[JSON_PARSER_STATS_STATES] = {
+  "start document", "in array", "in object", "end key", "after key", "after value", "array next",
+  "object next", "start escape", "unicode", "unicode surrogate", "t", "tr", "tru", "f", "fa", "fal",
+  "fals", "n", "nu", "nul",
+  "in string", "in number", "number fraction", "number exponent start", "number exponent",
+  "number minus", "number zero", "number fraction start", "number exponent sign"
+};
+
+static const char* const eventNames[JSON_EVENT_COUNT] = {
+  "startDocument", "endDocument", "startObject", "endObject", "startArray", "endArray", "value"
+};
+
+void JsonParserStats::print(Print& out) const {
+  out.println("Bytes per state:");
+  for (int i = 0; i < JSON_PARSER_STATS_STATES; i++) {
+    if (stateBytes[i] > 0) {
+      out.print("  "); out.print(stateNames[i]); out.print(": "); out.println((unsigned long) stateBytes[i]);
+    }
+  }
+  out.println("Events:");
+  for (int i = 0; i < JSON_EVENT_COUNT; i++) {
+    out.print("  "); out.print(eventNames[i]); out.print(": "); out.println((unsigned long) events[i]);
+  }
+  out.print("Keys/strings/numbers: "); out.print((unsigned long) keys); out.print("/");
+  out.print((unsigned long) strings); out.print("/"); out.println((unsigned long) numbers);
+  out.print("Max buffer fill: "); out.println(maxBufferFill);
+  out.print("Max depth: "); out.println(maxDepth);
+  out.print("Yields: "); out.println((unsigned long) yields);
+  out.print("Cycles parser/handler: "); out.print((unsigned long) getParserCycles());
+  out.print("/"); out.println((unsigned long) handlerCycles);
+}
+
+#endif // JSON_PARSER_STATS
@@ -0,0 +1,97 @@
+#ifndef JSON_PARSER_STATS_H
+#define JSON_PARSER_STATS_H
+
+#include <Arduino.h>
+
+/*
+  Optional hot-path instrumentation, enabled by building the library with
+  JSON_PARSER_STATS defined (e.g. build_flags = -DJSON_PARSER_STATS, as a
+  #define in a sketch does not reach the library's .cpp files). When
+  disabled, the JSON_STATS_* macros below compile to nothing and parsers
+  carry no extra state.
+*/
+
+#ifdef JSON_PARSER_STATS
+
+#if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32)
+  inline uint32_t jsonCycleCount() { return ESP.getCycleCount(); }
+#elif defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  inline uint32_t jsonCycleCount() { return (uint32_t) __rdtsc(); }
+#elif defined(__unix__) || defined(__APPLE__)
+  #include <time.h>
+  // nanoseconds rather than cycles
+  inline uint32_t jsonCycleCount() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) (now.tv_sec * 1000000000ULL + now.tv_nsec);
+  }
+#else
+  // microseconds rather than cycles
+  inline uint32_t jsonCycleCount() { return micros(); }
+#endif
+
+// Handler callbacks, as counted in JsonParserStats::events
+enum JsonParserEvent : uint8_t {
+  JSON_EVENT_START_DOCUMENT = 0,
+  JSON_EVENT_END_DOCUMENT   = 1,
+  JSON_EVENT_START_OBJECT   = 2,
+  JSON_EVENT_END_OBJECT     = 3,
+  JSON_EVENT_START_ARRAY    = 4,
+  JSON_EVENT_END_ARRAY      = 5,
+  JSON_EVENT_VALUE          = 6,
+  JSON_EVENT_COUNT          = 7
+};
+
+// Number of parser states (JSON_PARSER_STATE_COUNT)
+#define JSON_PARSER_STATS_STATES  30
+
+struct JsonParserStats {
+  // bytes fed in while in each STATE_*
+  uint32_t stateBytes[JSON_PARSER_STATS_STATES];
+  uint32_t events[JSON_EVENT_COUNT];
+  uint32_t keys;
+  uint32_t strings;
+  uint32_t numbers;
+  uint32_t yields;
+  // time spent in parse() overall and inside handler callbacks, in
+  // jsonCycleCount() units
+  uint32_t totalCycles;
+  uint32_t handlerCycles;
+  uint16_t maxBufferFill;
+  uint8_t maxDepth;
+
+  void clear() { memset(this, 0, sizeof(*this)); }
+
+  uint32_t getParserCycles() const { return totalCycles - handlerCycles; }
+
+  void print(Print& out) const;
+};
+
+#define JSON_STATS_STATE(s)          do { if ((s) < JSON_PARSER_STATS_STATES) stats.stateBytes[s]++; } while (0)
+#define JSON_STATS_STATE_BYTES(s, n) do { if ((s) < JSON_PARSER_STATS_STATES) stats.stateBytes[s] += (n); } while (0)
+#define JSON_STATS_COUNT(counter)    stats.counter++
+#define JSON_STATS_MAX(counter, v)   do { if ((v) > stats.counter) stats.counter = (v); } while (0)
+#define JSON_STATS_TIMER_START(t)    uint32_t t = jsonCycleCount()
+#define JSON_STATS_TIMER_STOP(t, counter)  stats.counter += jsonCycleCount() - (t)
+// Wraps a handler callback: counts the event and its time
+#define JSON_STATS_HANDLER(event, call)  do { \
+    uint32_t handlerStart = jsonCycleCount(); \
+    call; \
+    stats.handlerCycles += jsonCycleCount() - handlerStart; \
+    stats.events[event]++; \
+  } while (0)
+
+#else
+
+#define JSON_STATS_STATE(s)
+#define JSON_STATS_STATE_BYTES(s, n)
+#define JSON_STATS_COUNT(counter)
+#define JSON_STATS_MAX(counter, v)
+#define JSON_STATS_TIMER_START(t)
+#define JSON_STATS_TIMER_STOP(t, counter)
+#define JSON_STATS_HANDLER(event, call)  call
+
+#endif // JSON_PARSER_STATS
+
+#endif // JSON_PARSER_STATS_H
@@ -0,0 +1,24 @@
+#include "JsonPathHash.h"
+
+uint32_t jsonPathHashAppend(uint32_t hash, ElementSelector* selector, int level) {
+  if (selector->isObject()) {
+    if (level > 0) {
+      hash = jsonPathHashStep(hash, '.');
+    }
+    for (const char* key = selector->getKey(); *key; key++) {
+      hash = jsonPathHashStep(hash, *key);
+    }
+  } else {
+    hash = jsonPathHashStep(jsonPathHashStep(hash, '['), ']');
+  }
+  return hash;
+}
+
+uint32_t jsonPathHashOf(ElementPath& path) {
+  uint32_t hash = JSON_PATH_HASH_SEED;
+  int count = path.getCount();
+  for (int level = 0; level < count; level++) {
+    hash = jsonPathHashAppend(hash, path.get(level), level);
+  }
+  return hash;
+}
@@ -0,0 +1,40 @@
+#ifndef JSON_PATH_HASH_H
+#define JSON_PATH_HASH_H
+
+#include <Arduino.h>
+#include "ElementPath.h"
+
+/*
+  Hashes of normalized element paths.
+
+  A normalized path is what ElementPath::toString() builds, with every
+  array index collapsed to "[]": for example "list[].main.temp" matches
+  list[0].main.temp, list[1].main.temp and so on; root array items are "[]".
+
+  jsonPathHash() is constexpr, so path literals are hashed at compile time,
+  while jsonPathHashOf() computes the same hash for the current parser
+  position without building any string.
+*/
+
+#define JSON_PATH_HASH_SEED   2166136261UL
+#define JSON_PATH_HASH_PRIME  16777619UL
+
+constexpr uint32_t jsonPathHashStep(uint32_t hash, char c) {
+  return (uint32_t) ((hash ^ (uint8_t) c) * JSON_PATH_HASH_PRIME);
+}
+
+constexpr uint32_t jsonPathHash(const char* path, uint32_t hash = JSON_PATH_HASH_SEED) {
+  return *path ? jsonPathHash(path + 1, jsonPathHashStep(hash, *path)) : hash;
+}
+
+/*
+  Extends hash with the given selector as level-th path level.
+*/
+uint32_t jsonPathHashAppend(uint32_t hash, ElementSelector* selector, int level);
+
+/*
+  Hash of the normalized path of the current element.
+*/
+uint32_t jsonPathHashOf(ElementPath& path);
+
+#endif // JSON_PATH_HASH_H
@@ -0,0 +1,123 @@
+#include "JsonRingBuffer.h"
+
+// the data before an index, published with it
+#define RING_LOAD(index)  __atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+#define RING_STORE(index, value)  __atomic_store_n(&(index), (value), __ATOMIC_RELEASE)
+
+JsonRingBuffer::JsonRingBuffer(char* storage, size_t size) {
+  data = storage;
+  size_t capacity = 1;
+  while (capacity <= size / 2) {
+    capacity <<= 1;
+  }
+  mask = capacity - 1;
+}
+
+void JsonRingBuffer::reset() {
+  head = 0;
+  cachedTail = 0;
+  tail = 0;
+  cachedHead = 0;
+  closed = false;
+}
+
+size_t JsonRingBuffer::reserve(char** region) {
+  size_t capacity = mask + 1;
+  if (head - cachedTail == capacity) {
+    // only look at the consumer's index when the cached one says full
+    cachedTail = RING_LOAD(tail);
+  }
+  size_t free = capacity - (head - cachedTail);
+  size_t offset = head & mask;
+  *region = data + offset;
+  return free < capacity - offset ? free : capacity - offset;
+}
+
+void JsonRingBuffer::commit(size_t length) {
+  RING_STORE(head, head + length);
+}
+
+size_t JsonRingBuffer::write(const char* bytes, size_t length) {
+  size_t written = 0;
+  while (written < length) {
+    char* region;
+    size_t run = reserve(&region);
+    if (run == 0) {
+      break;
+    }
+    if (run > length - written) {
+      run = length - written;
+    }
+    memcpy(region, bytes + written, run);
+    commit(run);
+    written += run;
+  }
+  return written;
+}
+
+size_t JsonRingBuffer::availableForWrite() {
+  cachedTail = RING_LOAD(tail);
+  return mask + 1 - (head - cachedTail);
+}
+
+void JsonRingBuffer::close() {
+  RING_STORE(closed, true);
+}
+
+size_t JsonRingBuffer::peek(const char** region) {
+  if (cachedHead == tail) {
+    cachedHead = RING_LOAD(head);
+  }
+  size_t filled = cachedHead - tail;
+  size_t offset = tail & mask;
+  *region = data + offset;
+  return filled < mask + 1 - offset ? filled : mask + 1 - offset;
+}
+
+void JsonRingBuffer::consume(size_t length) {
+  RING_STORE(tail, tail + length);
+}
+
+size_t JsonRingBuffer::available() {
+  cachedHead = RING_LOAD(head);
+  return cachedHead - tail;
+}
+
+bool JsonRingBuffer::isFinished() {
+  // closed is published after the last commit
+  return RING_LOAD(closed) && available() == 0;
+}
+
+size_t JsonRingBuffer::pump(JsonStreamingParserBase* parser) {
+  size_t total = 0;
+  const char* region;
+  size_t length;
+  while ((length = peek(&region)) > 0) {
+    size_t consumed = parser->parse(region, length);
+    consume(consumed);
+    total += consumed;
+    if (parser->isDocumentComplete() || parser->hasParseError()) {
+      break;
+    }
+  }
+  return total;
+}
+
+size_t JsonRingBufferStream::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t JsonRingBufferStream::write(const uint8_t *buffer, size_t size) {
+  size_t written = target->write((const char*) buffer, size);
+  uint32_t lastProgress = millis();
+  while (written < size && millis() - lastProgress < timeout) {
+    // backpressure: wait for the consumer
+    delay(1);
+    size_t run = target->write((const char*) buffer + written, size - written);
+    if (run > 0) {
+      written += run;
+      lastProgress = millis();
+    }
+  }
+  return written;
+}
@@ -0,0 +1,150 @@
+#ifndef JSON_RING_BUFFER_H
+#define JSON_RING_BUFFER_H
+
+#include "Stream.h"
+#include <Arduino.h>
+#include "JsonStreamingParser2.h"
+
+#ifndef JSON_RING_BUFFER_WRITE_TIMEOUT
+#define JSON_RING_BUFFER_WRITE_TIMEOUT  5000
+#endif
+
+/*
+  Bounded single-producer/single-consumer byte queue, lock-free, for
+  receiving on one core, task or thread and parsing on another (e.g. TLS
+  decryption in loop() and parsing on the ESP32's other core).
+
+  The producer reserves contiguous free space, fills it in place (e.g.
+  client.read(region, length)) and commits it; the consumer peeks at
+  contiguous filled space, parses it in place and consumes it. Nothing
+  is copied in between. A full buffer is the producer's backpressure:
+  reserve() returns 0 until the consumer catches up.
+
+  Exactly one producer and one consumer may use it at a time; the
+  capacity is the largest power of two that fits the storage.
+*/
+class JsonRingBuffer {
+  private:
+    char* data;
+    size_t mask;
+
+#ifndef ARDUINO
+    // keeps the two sides' indices on separate cache lines
+    char producerPad[64];
+#endif
+    // written by the producer only
+    size_t head = 0;
+    size_t cachedTail = 0;
+    bool closed = false;
+
+#ifndef ARDUINO
+    char consumerPad[64];
+#endif
+    // written by the consumer only
+    size_t tail = 0;
+    size_t cachedHead = 0;
+
+  public:
+    JsonRingBuffer(char* storage, size_t size);
+
+    /*
+      Empties the buffer. Neither side may be using it.
+    */
+    void reset();
+
+    size_t getCapacity() const { return mask + 1; }
+
+    /*
+      Producer: points region at the contiguous free space and returns its
+      length, 0 if the buffer is full.
+    */
+    size_t reserve(char** region);
+
+    /*
+      Producer: hands the first length bytes of the reserved region over
+      to the consumer.
+    */
+    void commit(size_t length);
+
+    /*
+      Producer: copies as much of bytes as fits, returns the number of
+      bytes taken.
+    */
+    size_t write(const char* bytes, size_t length);
+
+    size_t availableForWrite();
+
+    /*
+      Producer: no more data will follow.
+    */
+    void close();
+
+    /*
+      Consumer: points region at the contiguous filled space and returns
+      its length, 0 if the buffer is empty.
+    */
+    size_t peek(const char** region);
+
+    /*
+      Consumer: releases the first length bytes of the peeked region.
+    */
+    void consume(size_t length);
+
+    size_t available();
+
+    /*
+      Consumer: true once the producer has closed the buffer and
+      everything has been consumed.
+    */
+    bool isFinished();
+
+    /*
+      Consumer: parses everything available in place. Stops at the end of
+      the document or at the first error, leaving the rest in the buffer.
+      Returns the number of bytes consumed.
+    */
+    size_t pump(JsonStreamingParserBase* parser);
+};
+
+/*
+  Ring buffer embedding its storage; SIZE should be a power of two.
+*/
+template <size_t SIZE>
+class StaticJsonRingBuffer: public JsonRingBuffer {
+  private:
+    char storage[SIZE];
+
+  public:
+    StaticJsonRingBuffer() : JsonRingBuffer(storage, SIZE) { }
+};
+
+/*
+  Producer side as a Stream, for http.writeToStream(&stream). Writes wait
+  for space while the consumer drains the buffer, up to the timeout.
+*/
+class JsonRingBufferStream: public Stream {
+  private:
+    JsonRingBuffer* target;
+    uint32_t timeout = JSON_RING_BUFFER_WRITE_TIMEOUT;
+
+  public:
+    JsonRingBufferStream(JsonRingBuffer* buffer) : target(buffer) { }
+
+    /*
+      Milliseconds a write waits for the consumer to free some space
+      before giving up.
+    */
+    void setWriteTimeout(uint32_t timeout) { this->timeout = timeout; }
+
+    virtual size_t write(uint8_t c);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    virtual void flush() { }
+
+    virtual int availableForWrite() { return target->availableForWrite(); }
+};
+
+#endif // JSON_RING_BUFFER_H
@@ -0,0 +1,39 @@
+#include "JsonScratchPool.h"
+
+JsonScratchPool::JsonScratchPool(char* storage, int bufferSize, int count) {
+  if (count > JSON_SCRATCH_POOL_MAX_BUFFERS) {
+    count = JSON_SCRATCH_POOL_MAX_BUFFERS;
+  }
+  this->storage = storage;
+  this->bufferSize = bufferSize;
+  this->count = count;
+  this->freeMask = count >= 32 ? 0xFFFFFFFFUL : ((1UL << count) - 1);
+}
+
+char* JsonScratchPool::acquire() {
+  if (freeMask == 0) {
+    return nullptr;
+  }
+  int slot = 0;
+  while (!(freeMask & (1UL << slot))) {
+    slot++;
+  }
+  freeMask &= ~(1UL << slot);
+  return storage + slot * bufferSize;
+}
+
+void JsonScratchPool::release(char* buffer) {
+  if (buffer < storage || buffer >= storage + count * bufferSize) {
+    return;
+  }
+  int slot = (buffer - storage) / bufferSize;
+  freeMask |= 1UL << slot;
+}
+
+int JsonScratchPool::getFreeCount() const {
+  int free = 0;
+  for (uint32_t mask = freeMask; mask != 0; mask &= mask - 1) {
+    free++;
+  }
+  return free;
+}
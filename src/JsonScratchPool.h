@@ -0,0 +1,57 @@
+#ifndef JSON_SCRATCH_POOL_H
+#define JSON_SCRATCH_POOL_H
+
+#include <Arduino.h>
+
+#define JSON_SCRATCH_POOL_MAX_BUFFERS  32
+
+/*
+  Shared pool of scratch buffers for parsers.
+
+  A parser only needs its string/number buffer while a string, number or
+  literal is being parsed. Parsers attached to a pool (see
+  JsonStreamingParserBase::setScratchPool) borrow a buffer at the start of
+  such a token and give it back at its end, so many mostly idle parsers
+  (e.g. long-poll connections) can share a handful of buffers.
+
+  Not thread-safe: use one pool per thread/task.
+*/
+class JsonScratchPool {
+  private:
+    char* storage;
+    uint16_t bufferSize;
+    uint8_t count;
+    uint32_t freeMask;
+
+  public:
+    /*
+      Builds a pool of count (at most 32) buffers of bufferSize chars each,
+      carved out of storage (count * bufferSize chars).
+    */
+    JsonScratchPool(char* storage, int bufferSize, int count);
+
+    /*
+      Returns a free buffer, or nullptr if they are all in use.
+    */
+    char* acquire();
+
+    void release(char* buffer);
+
+    int getBufferSize() const { return bufferSize; }
+
+    int getFreeCount() const;
+};
+
+/*
+  Pool embedding its own storage.
+*/
+template <int BUFFER_SIZE, int COUNT>
+class StaticJsonScratchPool: public JsonScratchPool {
+  private:
+    char poolStorage[BUFFER_SIZE * COUNT];
+
+  public:
+    StaticJsonScratchPool() : JsonScratchPool(poolStorage, BUFFER_SIZE, COUNT) { }
+};
+
+#endif // JSON_SCRATCH_POOL_H
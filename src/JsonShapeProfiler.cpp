@@ -0,0 +1,283 @@
+#include "JsonShapeProfiler.h"
+#include "JsonPathHash.h"
+
+static const char* const typeNames[] = { "object", "array", "string", "int", "float", "bool", "null" };
+
+JsonShapeProfiler::JsonShapeProfiler(JsonShapeEntry* entries, int maxEntries, char* keyText, size_t keyTextSize,
+                                     JsonShapeFrame* frames, int maxDepth) {
+  this->entries = entries;
+  this->maxEntries = maxEntries < 65535 ? maxEntries : 65535;
+  this->keyText = keyText;
+  this->keyTextSize = keyTextSize < 65535 ? keyTextSize : 65535;
+  this->frames = frames;
+  this->maxFrames = maxDepth < 255 ? maxDepth : 255;
+  reset();
+}
+
+void JsonShapeProfiler::reset() {
+  documents = 0;
+  totalBytes = 0;
+  dropped = 0;
+  lastCount = 0;
+  documentStart = 0;
+  entryCount = 0;
+  keyTextUsed = 0;
+  hint = 0;
+  maxKeyLength = 0;
+  maxStringLength = 0;
+  maxNumberLength = 0;
+  depth = 0;
+  maxDepth = 0;
+}
+
+uint32_t JsonShapeProfiler::position() {
+  return parser != nullptr ? parser->getCharacterCount() : 0;
+}
+
+uint16_t JsonShapeProfiler::find(uint32_t hash, uint16_t parent, const char* key) {
+  for (uint16_t n = 0; n < entryCount; n++) {
+    uint16_t i = hint + n < entryCount ? hint + n : hint + n - entryCount;
+    JsonShapeEntry& entry = entries[i];
+    if (entry.hash == hash && entry.parent == parent
+        && (key == nullptr ? entry.keyOffset == JSON_SHAPE_ITEM
+                           : entry.keyOffset != JSON_SHAPE_ITEM && strcmp(keyText + entry.keyOffset, key) == 0)) {
+      hint = i + 1 < entryCount ? i + 1 : 0;
+      return i;
+    }
+  }
+  return JSON_SHAPE_NONE;
+}
+
+/*
+  Finds or adds the entry of the current element and counts it.
+*/
+uint16_t JsonShapeProfiler::enter(ElementPath& path, uint8_t type) {
+  int level = path.getCount();
+  uint16_t parent = JSON_SHAPE_NONE;
+  uint32_t hash = JSON_PATH_HASH_SEED;
+  const char* key = nullptr;
+  if (level > 0) {
+    if (level > maxFrames || frames[level - 1].entry == JSON_SHAPE_NONE) {
+      // nested too deep, or within a dropped path
+      dropped++;
+      return JSON_SHAPE_NONE;
+    }
+    parent = frames[level - 1].entry;
+    ElementSelector* selector = path.getCurrent();
+    hash = jsonPathHashAppend(entries[parent].hash, selector, level - 1);
+    if (selector->isObject()) {
+      key = selector->getKey();
+    }
+  }
+
+  uint16_t index = find(hash, parent, key);
+  if (index == JSON_SHAPE_NONE) {
+    size_t keyLength = key != nullptr ? strlen(key) : 0;
+    if (entryCount >= maxEntries || (key != nullptr && keyTextUsed + keyLength + 1 > keyTextSize)) {
+      dropped++;
+      return JSON_SHAPE_NONE;
+    }
+    index = entryCount++;
+    JsonShapeEntry& entry = entries[index];
+    entry.hash = hash;
+    entry.count = 0;
+    entry.bytes = 0;
+    entry.parent = parent;
+    entry.maxLength = 0;
+    entry.types = 0;
+    if (key != nullptr) {
+      entry.keyOffset = keyTextUsed;
+      memcpy(keyText + keyTextUsed, key, keyLength + 1);
+      keyTextUsed += keyLength + 1;
+      if (keyLength > maxKeyLength) {
+        maxKeyLength = keyLength;
+      }
+    } else {
+      entry.keyOffset = JSON_SHAPE_ITEM;
+    }
+  }
+  entries[index].count++;
+  entries[index].types |= type;
+  return index;
+}
+
+void JsonShapeProfiler::startDocument() {
+  documentStart = lastCount = position();
+  depth = 0;
+}
+
+void JsonShapeProfiler::endDocument() {
+  documents++;
+  totalBytes += position() - documentStart;
+}
+
+void JsonShapeProfiler::startObject(ElementPath path) {
+  uint16_t index = enter(path, JSON_SHAPE_OBJECT);
+  if (depth < maxFrames) {
+    frames[depth].entry = index;
+    frames[depth].start = lastCount;
+  }
+  depth++;
+  if (depth > maxDepth) {
+    maxDepth = depth;
+  }
+  lastCount = position();
+}
+
+void JsonShapeProfiler::endObject(ElementPath /* path */) {
+  lastCount = position();
+  if (depth == 0) {
+    return;
+  }
+  depth--;
+  if (depth < maxFrames && frames[depth].entry != JSON_SHAPE_NONE) {
+    entries[frames[depth].entry].bytes += lastCount - frames[depth].start;
+  }
+}
+
+void JsonShapeProfiler::startArray(ElementPath path) {
+  uint16_t index = enter(path, JSON_SHAPE_ARRAY);
+  if (depth < maxFrames) {
+    frames[depth].entry = index;
+    frames[depth].start = lastCount;
+  }
+  depth++;
+  if (depth > maxDepth) {
+    maxDepth = depth;
+  }
+  lastCount = position();
+}
+
+void JsonShapeProfiler::endArray(ElementPath path) {
+  endObject(path);
+}
+
+void JsonShapeProfiler::value(ElementPath path, ElementValue value) {
+  uint8_t type;
+  uint16_t length = 0;
+  if (value.isString()) {
+    type = JSON_SHAPE_STRING;
+    size_t stringLength = strlen(value.getString());
+    length = stringLength < 65535 ? stringLength : 65535;
+    if (length > maxStringLength) {
+      maxStringLength = length;
+    }
+  } else if (value.isInt() || value.isFloat()) {
+    type = value.isInt() ? JSON_SHAPE_INT : JSON_SHAPE_FLOAT;
+    length = value.getNumberLength();
+    if (length > maxNumberLength) {
+      maxNumberLength = length;
+    }
+  } else {
+    type = value.isBool() ? JSON_SHAPE_BOOL : JSON_SHAPE_NULL;
+  }
+
+  uint16_t index = enter(path, type);
+  uint32_t now = position();
+  if (index != JSON_SHAPE_NONE) {
+    JsonShapeEntry& entry = entries[index];
+    entry.bytes += now - lastCount;
+    if (length > entry.maxLength) {
+      entry.maxLength = length;
+    }
+  }
+  lastCount = now;
+}
+
+void JsonShapeProfiler::whitespace(char /* c */) {
+}
+
+int JsonShapeProfiler::getSuggestedBufferSize() const {
+  uint16_t longest = maxKeyLength;
+  if (maxStringLength > longest) {
+    longest = maxStringLength;
+  }
+  if (maxNumberLength > longest) {
+    longest = maxNumberLength;
+  }
+  return longest + 1;
+}
+
+/*
+  Path key storage the entry takes: its key and those of its parents,
+  each with a NUL.
+*/
+size_t JsonShapeProfiler::keyStorageOf(uint16_t index) const {
+  size_t size = 0;
+  for (uint16_t i = index; entries[i].parent != JSON_SHAPE_NONE; i = entries[i].parent) {
+    size += entries[i].keyOffset != JSON_SHAPE_ITEM ? strlen(keyText + entries[i].keyOffset) + 1 : 1;
+  }
+  return size;
+}
+
+int JsonShapeProfiler::getSuggestedKeyLength() const {
+  size_t needed = 1;
+  for (uint16_t i = 0; i < entryCount; i++) {
+    size_t size = keyStorageOf(i);
+    if (size > needed) {
+      needed = size;
+    }
+  }
+  int depth = getSuggestedPathDepth();
+  return (needed + depth - 1) / depth;
+}
+
+void JsonShapeProfiler::printPath(Print& out, uint16_t index) {
+  const JsonShapeEntry& entry = entries[index];
+  if (entry.parent == JSON_SHAPE_NONE) {
+    return;
+  }
+  printPath(out, entry.parent);
+  if (entry.keyOffset == JSON_SHAPE_ITEM) {
+    out.print("[]");
+  } else {
+    if (entries[entry.parent].parent != JSON_SHAPE_NONE) {
+      out.print('.');
+    }
+    out.print(keyText + entry.keyOffset);
+  }
+}
+
+void JsonShapeProfiler::print(Print& out) {
+  out.print("Documents: "); out.print((unsigned long) documents);
+  out.print(", bytes: "); out.print((unsigned long) totalBytes);
+  out.print(", paths: "); out.print((unsigned long) entryCount);
+  out.print(", dropped: "); out.println((unsigned long) dropped);
+  out.print("Longest key/string/number: "); out.print((unsigned long) maxKeyLength);
+  out.print("/"); out.print((unsigned long) maxStringLength);
+  out.print("/"); out.print((unsigned long) maxNumberLength);
+  out.print(", max depth: "); out.println((unsigned long) maxDepth);
+  out.print("Suggested: JSON_PARSER_BUFFER_MAX_LENGTH "); out.print(getSuggestedBufferSize());
+  out.print(", JSON_PARSER_KEY_MAX_LENGTH "); out.print(getSuggestedKeyLength());
+  out.print(", JSON_PARSER_PATH_MAX_DEPTH "); out.print(getSuggestedPathDepth());
+  out.print(", JSON_PARSER_STACK_MAX_DEPTH "); out.println(getSuggestedStackDepth());
+
+  for (uint16_t i = 0; i < entryCount; i++) {
+    const JsonShapeEntry& entry = entries[i];
+    out.print("  ");
+    if (entry.parent == JSON_SHAPE_NONE) {
+      out.print("(document)");
+    } else {
+      printPath(out, i);
+    }
+    out.print(": "); out.print((unsigned long) entry.count); out.print("x ");
+    bool first = true;
+    for (uint8_t bit = 0; bit < sizeof(typeNames) / sizeof(typeNames[0]); bit++) {
+      if (entry.types & (1 << bit)) {
+        if (!first) {
+          out.print("|");
+        }
+        out.print(typeNames[bit]);
+        first = false;
+      }
+    }
+    if (entry.maxLength > 0) {
+      out.print(", max length "); out.print((unsigned long) entry.maxLength);
+    }
+    if (totalBytes > 0) {
+      out.print(", "); out.print((unsigned long) entry.bytes); out.print(" bytes (");
+      out.print(100.0 * entry.bytes / totalBytes, 1); out.print("%)");
+    }
+    out.println();
+  }
+}
@@ -0,0 +1,155 @@
+#ifndef JSON_SHAPE_PROFILER_H
+#define JSON_SHAPE_PROFILER_H
+
+#include <Arduino.h>
+#include "JsonHandler.h"
+#include "JsonStreamingParser2.h"
+
+// JsonShapeEntry::types
+#define JSON_SHAPE_OBJECT  0x01
+#define JSON_SHAPE_ARRAY   0x02
+#define JSON_SHAPE_STRING  0x04
+#define JSON_SHAPE_INT     0x08
+#define JSON_SHAPE_FLOAT   0x10
+#define JSON_SHAPE_BOOL    0x20
+#define JSON_SHAPE_NULL    0x40
+
+// JsonShapeEntry::parent of the document root
+#define JSON_SHAPE_NONE    0xFFFF
+// JsonShapeEntry::keyOffset of array items
+#define JSON_SHAPE_ITEM    0xFFFF
+
+/*
+  One normalized path (array indices collapsed, as in JsonPathHash.h):
+  its last level, and what was seen there.
+*/
+struct JsonShapeEntry {
+  uint32_t hash;
+  uint32_t count;
+  // bytes of all occurrences, including their keys and separators
+  uint32_t bytes;
+  uint16_t parent;
+  uint16_t keyOffset;
+  // longest string or number
+  uint16_t maxLength;
+  uint8_t types;
+};
+
+/*
+  Open object or array.
+*/
+struct JsonShapeFrame {
+  uint16_t entry;
+  uint32_t start;
+};
+
+/*
+  Handler profiling the shape of documents, to size parser buffers and
+  design filters from real data rather than guesses. For every
+  normalized path it counts occurrences and records the value types,
+  the longest string or number, and the bytes of the subtree, whose
+  share of the document is the share of the parsing work spent there.
+  Overall it reports the longest key, string and number and the deepest
+  nesting, with the parser sizes they call for.
+
+  Byte counts need the parser (setParser); keys are as long as the
+  parser's path keeps them, so profile with generous key lengths (e.g.
+  with the ShapeProfiler host tool in extras/). Paths beyond maxEntries
+  or the key storage are counted in getDroppedCount() only.
+*/
+class JsonShapeProfiler: public JsonHandler {
+  private:
+    JsonShapeEntry* entries;
+    char* keyText;
+    JsonShapeFrame* frames;
+    JsonStreamingParserBase* parser = nullptr;
+
+    uint32_t documents;
+    uint32_t totalBytes;
+    uint32_t dropped;
+    uint32_t lastCount;
+    uint32_t documentStart;
+
+    uint16_t maxEntries;
+    uint16_t entryCount;
+    uint16_t keyTextSize;
+    uint16_t keyTextUsed;
+    // where the next lookup starts: documents tend to repeat their order
+    uint16_t hint;
+    uint16_t maxKeyLength;
+    uint16_t maxStringLength;
+    uint16_t maxNumberLength;
+
+    uint8_t maxFrames;
+    uint8_t depth;
+    uint8_t maxDepth;
+
+    uint32_t position();
+    uint16_t enter(ElementPath& path, uint8_t type);
+    uint16_t find(uint32_t hash, uint16_t parent, const char* key);
+    void printPath(Print& out, uint16_t index);
+    size_t keyStorageOf(uint16_t index) const;
+
+  public:
+    JsonShapeProfiler(JsonShapeEntry* entries, int maxEntries, char* keyText, size_t keyTextSize,
+                      JsonShapeFrame* frames, int maxDepth);
+
+    /*
+      Measures bytes as consumed by this parser.
+    */
+    void setParser(JsonStreamingParserBase* parser) { this->parser = parser; }
+
+    void reset();
+
+    int getEntryCount() const { return entryCount; }
+    const JsonShapeEntry& getEntry(int index) const { return entries[index]; }
+    uint32_t getDroppedCount() const { return dropped; }
+    uint32_t getDocumentCount() const { return documents; }
+    uint32_t getTotalBytes() const { return totalBytes; }
+    int getMaxKeyLength() const { return maxKeyLength; }
+    int getMaxStringLength() const { return maxStringLength; }
+    int getMaxNumberLength() const { return maxNumberLength; }
+    int getMaxDepth() const { return maxDepth; }
+
+    /*
+      Smallest parser sizes for the documents seen so far: the buffer
+      holds keys, strings and numbers, the stack an extra key and string
+      entry over the nesting depth, and the path's key storage (path
+      depth times key length) the keys of the deepest key path.
+    */
+    int getSuggestedBufferSize() const;
+    int getSuggestedKeyLength() const;
+    int getSuggestedPathDepth() const { return maxDepth > 0 ? maxDepth : 1; }
+    int getSuggestedStackDepth() const { return maxDepth + 3; }
+
+    /*
+      Prints the summary and one line per path, in document order.
+    */
+    void print(Print& out);
+
+    virtual void startDocument();
+    virtual void endDocument();
+    virtual void startObject(ElementPath path);
+    virtual void endObject(ElementPath path);
+    virtual void startArray(ElementPath path);
+    virtual void endArray(ElementPath path);
+    virtual void value(ElementPath path, ElementValue value);
+    virtual void whitespace(char c);
+};
+
+/*
+  Profiler embedding its storage.
+*/
+template <int MAX_ENTRIES, int KEY_TEXT_SIZE, int MAX_DEPTH>
+class StaticJsonShapeProfiler: public JsonShapeProfiler {
+  private:
+    JsonShapeEntry entryStorage[MAX_ENTRIES];
+    char keyStorage[KEY_TEXT_SIZE];
+    JsonShapeFrame frameStorage[MAX_DEPTH];
+
+  public:
+    StaticJsonShapeProfiler()
+      : JsonShapeProfiler(entryStorage, MAX_ENTRIES, keyStorage, KEY_TEXT_SIZE, frameStorage, MAX_DEPTH) { }
+};
+
+#endif // JSON_SHAPE_PROFILER_H
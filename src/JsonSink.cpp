@@ -0,0 +1,108 @@
+#include "JsonSink.h"
+
+JsonSink::JsonSink(char* buffer, size_t capacity, JsonSinkFlushCallback onFlush, void* context) {
+  this->buffer = buffer;
+  this->capacity = capacity;
+  this->onFlush = onFlush;
+  this->flushContext = context;
+}
+
+JsonSink::JsonSink(Print* out, char* buffer, size_t capacity) {
+  this->out = out;
+  this->buffer = buffer;
+  this->capacity = buffer != nullptr ? capacity : 0;
+}
+
+bool JsonSink::drain() {
+  if (length == 0) {
+    return true;
+  }
+  if (out != nullptr) {
+    if (out->write((const uint8_t*) buffer, length) != length) {
+      overflowed = true;
+    }
+  } else if (onFlush != nullptr) {
+    if (!onFlush(buffer, length, flushContext)) {
+      overflowed = true;
+    }
+  } else {
+    // Nowhere to drain to: keep the content, caller reads it via getData().
+    return false;
+  }
+  length = 0;
+  return !overflowed;
+}
+
+void JsonSink::write(char c) {
+  if (overflowed) {
+    return;
+  }
+  if (capacity == 0) {
+    if (out == nullptr || out->write((uint8_t) c) != 1) {
+      overflowed = true;
+      return;
+    }
+    written++;
+    return;
+  }
+  if (length >= capacity && !drain()) {
+    overflowed = true;
+    return;
+  }
+  buffer[length++] = c;
+  written++;
+}
+
+void JsonSink::write(const char* data, size_t size) {
+  if (overflowed) {
+    return;
+  }
+  if (capacity == 0) {
+    if (out == nullptr || out->write((const uint8_t*) data, size) != size) {
+      overflowed = true;
+      return;
+    }
+    written += size;
+    return;
+  }
+  while (size > 0) {
+    if (length >= capacity && !drain()) {
+      overflowed = true;
+      return;
+    }
+    size_t chunk = capacity - length;
+    if (chunk > size) {
+      chunk = size;
+    }
+    memcpy(buffer + length, data, chunk);
+    length += chunk;
+    written += chunk;
+    data += chunk;
+    size -= chunk;
+  }
+}
+
+void JsonSink::write(const char* data) {
+  write(data, strlen(data));
+}
+
+bool JsonSink::flush() {
+  if (overflowed) {
+    return false;
+  }
+  if (out == nullptr && onFlush == nullptr) {
+    // Plain buffer: content stays available through getData().
+    return true;
+  }
+  bool result = drain();
+  if (out != nullptr) {
+    out->flush();
+  }
+  return result;
+}
+
+void JsonSink::clear() {
+  length = 0;
+  written = 0;
+  overflowed = false;
+}
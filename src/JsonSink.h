@@ -0,0 +1,81 @@
+#ifndef JSON_SINK_H
+#define JSON_SINK_H
+
+#include <Arduino.h>
+#include "Print.h"
+
+/*
+  Called whenever a buffered sink has to hand its content over, either
+  because the buffer is full or because flush() was requested.
+  Returning false aborts the output (the sink is marked as overflowed).
+*/
+typedef bool (*JsonSinkFlushCallback)(const char* data, size_t length, void* context);
+
+/*
+  Fixed-memory output channel shared by the library's writers.
+  It never allocates: bytes go either into a caller-provided buffer
+  (drained through an optional flush callback when full) or to a
+  Print/Stream, optionally batched through a caller-provided buffer.
+*/
+class JsonSink {
+  private:
+    char* buffer = nullptr;
+    size_t capacity = 0;
+    size_t length = 0;
+
+    Print* out = nullptr;
+
+    JsonSinkFlushCallback onFlush = nullptr;
+    void* flushContext = nullptr;
+
+    bool overflowed = false;
+    size_t written = 0;
+
+    bool drain();
+
+  public:
+    /*
+      Writes into the given buffer; once it is full, the content is handed
+      to onFlush (if any) and the buffer is reused, otherwise further output
+      is dropped and hasOverflowed() reports it.
+    */
+    JsonSink(char* buffer, size_t capacity, JsonSinkFlushCallback onFlush = nullptr, void* context = nullptr);
+
+    /*
+      Writes straight to the given Print/Stream; if a buffer is given, output
+      is batched and written out in chunks of its size.
+    */
+    JsonSink(Print* out, char* buffer = nullptr, size_t capacity = 0);
+
+    void write(char c);
+
+    void write(const char* data, size_t length);
+
+    void write(const char* data);
+
+    /*
+      Hands any pending buffered bytes to the Print/callback.
+    */
+    bool flush();
+
+    /*
+      Forgets buffered content and the overflow state.
+    */
+    void clear();
+
+    /*
+      Buffered (not yet flushed) content. It is not NUL-terminated.
+    */
+    const char* getData() const { return buffer; }
+
+    size_t getLength() const { return length; }
+
+    /*
+      Total bytes accepted since construction (or last clear()).
+    */
+    size_t getWrittenCount() const { return written; }
+
+    bool hasOverflowed() const { return overflowed; }
+};
+
+#endif // JSON_SINK_H
@@ -1,339 +1,849 @@
 #include "JsonStreamingParser2.h"
+#include "JsonPathHash.h"
+#include "JsonDigits.h"
 
-JsonStreamingParser::JsonStreamingParser() {
+/*
+  Table-driven state machine.
+
+  Every byte is mapped to one of a few byte classes, and (state, class)
+  indexes a transition table. An entry below JSON_PARSER_STATE_COUNT is
+  simply the next state (appending the byte to the buffer when that state
+  collects a string or number), which covers whitespace skipping, literal
+  matching and the bytes inside strings and numbers. Other entries are
+  actions, only taken at token boundaries, or errors.
+
+  Both tables are computed at compile time by the constexpr functions
+  below, and are small enough (about 1 KB) to stay in RAM/cache.
+*/
+
+enum JsonByteClass : uint8_t {
+  CLASS_OTHER = 0,  // anything else, including UTF-8 sequences
+  CLASS_SPACE,
+  CLASS_WHITESPACE, // \t \n \r
+  CLASS_CONTROL,    // other control characters
+  CLASS_BEGIN_OBJECT,
+  CLASS_END_OBJECT,
+  CLASS_BEGIN_ARRAY,
+  CLASS_END_ARRAY,
+  CLASS_COLON,
+  CLASS_COMMA,
+  CLASS_QUOTE,
+  CLASS_BACKSLASH,
+  CLASS_SLASH,
+  CLASS_MINUS,
+  CLASS_PLUS,
+  CLASS_DOT,
+  CLASS_DIGIT,
+  CLASS_UPPER_E,
+  // letters of the literals and escapes
+  CLASS_A, CLASS_B, CLASS_E, CLASS_F, CLASS_L, CLASS_N, CLASS_R, CLASS_S, CLASS_T, CLASS_U,
+  // '0', which cannot be followed by digits
+  CLASS_ZERO,
+  CLASS_COUNT
+};
+
+// Transition table entries from 0x20 on
+static constexpr uint8_t ACTION_START_OBJECT = 0x20;
+static constexpr uint8_t ACTION_END_OBJECT = 0x21;
+static constexpr uint8_t ACTION_START_ARRAY = 0x22;
+static constexpr uint8_t ACTION_END_ARRAY = 0x23;
+static constexpr uint8_t ACTION_START_KEY = 0x24;
+static constexpr uint8_t ACTION_START_STRING = 0x25;
+static constexpr uint8_t ACTION_END_STRING = 0x26;
+static constexpr uint8_t ACTION_START_NUMBER = 0x27;
+static constexpr uint8_t ACTION_END_NUMBER = 0x28;
+static constexpr uint8_t ACTION_END_TRUE = 0x29;
+static constexpr uint8_t ACTION_END_FALSE = 0x2A;
+static constexpr uint8_t ACTION_END_NULL = 0x2B;
+static constexpr uint8_t ACTION_ESCAPE = 0x2C;
+static constexpr uint8_t ACTION_UNICODE = 0x2D;
+static constexpr uint8_t ACTION_UNICODE_SURROGATE = 0x2E;
+static constexpr uint8_t ACTION_NEXT_VALUE = 0x2F;
+static constexpr uint8_t ACTION_AFTER_VALUE_ERROR = 0x30;
+// errors, in the order of errorMessages
+static constexpr uint8_t ERROR_DOCUMENT_START = 0x31;
+static constexpr uint8_t ERROR_VALUE = 0x32;
+static constexpr uint8_t ERROR_KEY = 0x33;
+static constexpr uint8_t ERROR_COLON = 0x34;
+static constexpr uint8_t ERROR_ESCAPE = 0x35;
+static constexpr uint8_t ERROR_CONTROL_CHARACTER = 0x36;
+static constexpr uint8_t ERROR_TRUE = 0x37;
+static constexpr uint8_t ERROR_FALSE = 0x38;
+static constexpr uint8_t ERROR_NULL = 0x39;
+static constexpr uint8_t ERROR_MULTIPLE_DECIMAL_POINTS = 0x3A;
+static constexpr uint8_t ERROR_DECIMAL_POINT_IN_EXPONENT = 0x3B;
+static constexpr uint8_t ERROR_MULTIPLE_EXPONENTS = 0x3C;
+static constexpr uint8_t ERROR_SIGN = 0x3D;
+static constexpr uint8_t ERROR_DIGIT = 0x3E;
+static constexpr uint8_t ERROR_LEADING_ZERO = 0x3F;
+
+// actions counted as events by JsonParserBudget: starts and ends of
+// objects and arrays, keys and values
+static constexpr uint16_t EVENT_ACTIONS = 0x0F4F;
+
+static const char* const errorMessages[] = {
+  "Document must start with object or array",
+  "Unexpected character for value",
+  "Expected start of string for object key",
+  "Expected ':' after object key",
+  "Expected escaped character after backslash",
+  "Unescaped control character in string",
+  "Expected 'true' literal",
+  "Expected 'false' literal",
+  "Expected 'null' literal",
+  "Cannot have multiple decimal points in number",
+  "Cannot have decimal point in exponent",
+  "Cannot have multiple exponents in number",
+  "Can only have '+' or '-' after 'e' or 'E' in number",
+  "Expected digit in number",
+  "Cannot have leading zeros in number"
+};
+
+static_assert(JSON_PARSER_STATE_COUNT <= ACTION_START_OBJECT,
+              "states and actions share the transition table entries");
+
+constexpr uint8_t jsonByteClass(int c) {
+  return c == ' ' ? CLASS_SPACE
+       : (c == '\t' || c == '\n' || c == '\r') ? CLASS_WHITESPACE
+       : (c < 0x20 || c == 0x7F) ? CLASS_CONTROL
+       : c == '{' ? CLASS_BEGIN_OBJECT : c == '}' ? CLASS_END_OBJECT
+       : c == '[' ? CLASS_BEGIN_ARRAY : c == ']' ? CLASS_END_ARRAY
+       : c == ':' ? CLASS_COLON : c == ',' ? CLASS_COMMA
+       : c == '"' ? CLASS_QUOTE : c == '\\' ? CLASS_BACKSLASH : c == '/' ? CLASS_SLASH
+       : c == '-' ? CLASS_MINUS : c == '+' ? CLASS_PLUS : c == '.' ? CLASS_DOT
+       : c == '0' ? CLASS_ZERO : (c >= '1' && c <= '9') ? CLASS_DIGIT : c == 'E' ? CLASS_UPPER_E
+       : c == 'a' ? CLASS_A : c == 'b' ? CLASS_B : c == 'e' ? CLASS_E : c == 'f' ? CLASS_F
+       : c == 'l' ? CLASS_L : c == 'n' ? CLASS_N : c == 'r' ? CLASS_R : c == 's' ? CLASS_S
+       : c == 't' ? CLASS_T : c == 'u' ? CLASS_U
+       : CLASS_OTHER;
+}
+
+constexpr uint8_t toState(JsonParserState state) {
+  return state;
+}
+
+constexpr bool isWhitespaceClass(uint8_t c) {
+  return c == CLASS_SPACE || c == CLASS_WHITESPACE;
+}
+
+constexpr bool isDigitClass(uint8_t c) {
+  return c == CLASS_DIGIT || c == CLASS_ZERO;
+}
+
+// Start of a value, or whitespace before it
+constexpr uint8_t valueTransition(uint8_t state, uint8_t c, uint8_t error) {
+  return isWhitespaceClass(c) ? state
+       : c == CLASS_BEGIN_OBJECT ? ACTION_START_OBJECT
+       : c == CLASS_BEGIN_ARRAY ? ACTION_START_ARRAY
+       : c == CLASS_QUOTE ? ACTION_START_STRING
+       : (isDigitClass(c) || c == CLASS_MINUS) ? ACTION_START_NUMBER
+       : c == CLASS_T ? toState(STATE_IN_TRUE)
+       : c == CLASS_F ? toState(STATE_IN_FALSE)
+       : c == CLASS_N ? toState(STATE_IN_NULL)
+       : error;
+}
+
+constexpr uint8_t literalTransition(uint8_t c, uint8_t expected, uint8_t next, uint8_t error) {
+  return c == expected ? next : error;
+}
+
+constexpr uint8_t stringTransition(uint8_t c) {
+  return c == CLASS_QUOTE ? ACTION_END_STRING
+       : c == CLASS_BACKSLASH ? toState(STATE_START_ESCAPE)
+       : (c == CLASS_WHITESPACE || c == CLASS_CONTROL) ? ERROR_CONTROL_CHARACTER
+       : toState(STATE_IN_STRING);
+}
+
+constexpr uint8_t escapeTransition(uint8_t c) {
+  return c == CLASS_U ? toState(STATE_UNICODE)
+       : (c == CLASS_QUOTE || c == CLASS_BACKSLASH || c == CLASS_SLASH || c == CLASS_B || c == CLASS_F
+          || c == CLASS_N || c == CLASS_R || c == CLASS_T) ? ACTION_ESCAPE
+       : ERROR_ESCAPE;
+}
+
+// Number grammar of RFC 8259. In the states where a number may end, any
+// other byte ends it, and is then processed on its own
+constexpr uint8_t numberTransition(uint8_t state, uint8_t c) {
+  return state == STATE_NUMBER_MINUS
+         ? (c == CLASS_ZERO ? toState(STATE_NUMBER_ZERO) : c == CLASS_DIGIT ? toState(STATE_IN_NUMBER) : ERROR_DIGIT)
+       : state == STATE_NUMBER_FRACTION_START
+         ? (isDigitClass(c) ? toState(STATE_NUMBER_FRACTION) : ERROR_DIGIT)
+       : state == STATE_NUMBER_EXPONENT_SIGN
+         ? (isDigitClass(c) ? toState(STATE_NUMBER_EXPONENT) : ERROR_DIGIT)
+       : state == STATE_NUMBER_EXPONENT_START
+         ? (isDigitClass(c) ? toState(STATE_NUMBER_EXPONENT)
+           : (c == CLASS_PLUS || c == CLASS_MINUS) ? toState(STATE_NUMBER_EXPONENT_SIGN)
+           : c == CLASS_DOT ? ERROR_DECIMAL_POINT_IN_EXPONENT
+           : (c == CLASS_E || c == CLASS_UPPER_E) ? ERROR_MULTIPLE_EXPONENTS
+           : ERROR_DIGIT)
+       : isDigitClass(c)
+         ? (state == STATE_NUMBER_ZERO ? ERROR_LEADING_ZERO : state)
+       : c == CLASS_DOT
+         ? (state == STATE_IN_NUMBER || state == STATE_NUMBER_ZERO ? toState(STATE_NUMBER_FRACTION_START)
+           : state == STATE_NUMBER_FRACTION ? ERROR_MULTIPLE_DECIMAL_POINTS
+           : ERROR_DECIMAL_POINT_IN_EXPONENT)
+       : (c == CLASS_E || c == CLASS_UPPER_E)
+         ? (state != STATE_NUMBER_EXPONENT ? toState(STATE_NUMBER_EXPONENT_START) : ERROR_MULTIPLE_EXPONENTS)
+       : (c == CLASS_PLUS || c == CLASS_MINUS) ? ERROR_SIGN
+       : ACTION_END_NUMBER;
+}
+
+constexpr uint8_t jsonTransition(uint8_t state, uint8_t c) {
+  return state == STATE_START_DOCUMENT
+         ? (isWhitespaceClass(c) ? state
+           : c == CLASS_BEGIN_OBJECT ? ACTION_START_OBJECT
+           : c == CLASS_BEGIN_ARRAY ? ACTION_START_ARRAY
+           : ERROR_DOCUMENT_START)
+       : state == STATE_IN_ARRAY
+         ? (c == CLASS_END_ARRAY ? ACTION_END_ARRAY : valueTransition(state, c, ERROR_VALUE))
+       : state == STATE_IN_OBJECT
+         ? (isWhitespaceClass(c) ? state
+           : c == CLASS_END_OBJECT ? ACTION_END_OBJECT
+           : c == CLASS_QUOTE ? ACTION_START_KEY
+           : ERROR_KEY)
+       // after a comma: no trailing comma before the closing bracket
+       : state == STATE_ARRAY_NEXT
+         ? valueTransition(state, c, ERROR_VALUE)
+       : state == STATE_OBJECT_NEXT
+         ? (isWhitespaceClass(c) ? state : c == CLASS_QUOTE ? ACTION_START_KEY : ERROR_KEY)
+       : state == STATE_END_KEY
+         ? (isWhitespaceClass(c) ? state : c == CLASS_COLON ? toState(STATE_AFTER_KEY) : ERROR_COLON)
+       : state == STATE_AFTER_KEY
+         ? valueTransition(state, c, ERROR_VALUE)
+       : state == STATE_AFTER_VALUE
+         ? (isWhitespaceClass(c) ? state
+           : c == CLASS_COMMA ? ACTION_NEXT_VALUE
+           : c == CLASS_END_OBJECT ? ACTION_END_OBJECT
+           : c == CLASS_END_ARRAY ? ACTION_END_ARRAY
+           : ACTION_AFTER_VALUE_ERROR)
+       : state == STATE_START_ESCAPE ? escapeTransition(c)
+       : state == STATE_UNICODE ? ACTION_UNICODE
+       : state == STATE_UNICODE_SURROGATE ? ACTION_UNICODE_SURROGATE
+       : state == STATE_IN_TRUE ? literalTransition(c, CLASS_R, STATE_IN_TRUE_TR, ERROR_TRUE)
+       : state == STATE_IN_TRUE_TR ? literalTransition(c, CLASS_U, STATE_IN_TRUE_TRU, ERROR_TRUE)
+       : state == STATE_IN_TRUE_TRU ? literalTransition(c, CLASS_E, ACTION_END_TRUE, ERROR_TRUE)
+       : state == STATE_IN_FALSE ? literalTransition(c, CLASS_A, STATE_IN_FALSE_FA, ERROR_FALSE)
+       : state == STATE_IN_FALSE_FA ? literalTransition(c, CLASS_L, STATE_IN_FALSE_FAL, ERROR_FALSE)
+       : state == STATE_IN_FALSE_FAL ? literalTransition(c, CLASS_S, STATE_IN_FALSE_FALS, ERROR_FALSE)
+       : state == STATE_IN_FALSE_FALS ? literalTransition(c, CLASS_E, ACTION_END_FALSE, ERROR_FALSE)
+       : state == STATE_IN_NULL ? literalTransition(c, CLASS_U, STATE_IN_NULL_NU, ERROR_NULL)
+       : state == STATE_IN_NULL_NU ? literalTransition(c, CLASS_L, STATE_IN_NULL_NUL, ERROR_NULL)
+       : state == STATE_IN_NULL_NUL ? literalTransition(c, CLASS_L, ACTION_END_NULL, ERROR_NULL)
+       : state == STATE_IN_STRING ? stringTransition(c)
+       : numberTransition(state, c);
+}
+
+#define JSON_CLASS_1(c)   jsonByteClass(c)
+#define JSON_CLASS_4(c)   JSON_CLASS_1(c), JSON_CLASS_1(c + 1), JSON_CLASS_1(c + 2), JSON_CLASS_1(c + 3)
+#define JSON_CLASS_16(c)  JSON_CLASS_4(c), JSON_CLASS_4(c + 4), JSON_CLASS_4(c + 8), JSON_CLASS_4(c + 12)
+#define JSON_CLASS_64(c)  JSON_CLASS_16(c), JSON_CLASS_16(c + 16), JSON_CLASS_16(c + 32), JSON_CLASS_16(c + 48)
+
+static constexpr uint8_t byteClasses[256] = {
+  JSON_CLASS_64(0), JSON_CLASS_64(64), JSON_CLASS_64(128), JSON_CLASS_64(192)
+};
+
+#define JSON_TRANSITION_4(s, c)  jsonTransition(s, c), jsonTransition(s, c + 1), jsonTransition(s, c + 2), jsonTransition(s, c + 3)
+#define JSON_TRANSITIONS(s)  { JSON_TRANSITION_4(s, 0), JSON_TRANSITION_4(s, 4), JSON_TRANSITION_4(s, 8), \
+                               JSON_TRANSITION_4(s, 12), JSON_TRANSITION_4(s, 16), JSON_TRANSITION_4(s, 20), \
+                               JSON_TRANSITION_4(s, 24), jsonTransition(s, 28) }
+
+static_assert(CLASS_COUNT == 29, "JSON_TRANSITIONS covers 29 byte classes");
+static_assert(JSON_PARSER_STATE_COUNT == 30, "transitions covers 30 states");
+#ifdef JSON_PARSER_STATS
+static_assert(JSON_PARSER_STATS_STATES == JSON_PARSER_STATE_COUNT, "JsonParserStats covers every state");
+#endif
+
+static constexpr uint8_t transitions[JSON_PARSER_STATE_COUNT][CLASS_COUNT] = {
+  JSON_TRANSITIONS(0),  JSON_TRANSITIONS(1),  JSON_TRANSITIONS(2),  JSON_TRANSITIONS(3),
+  JSON_TRANSITIONS(4),  JSON_TRANSITIONS(5),  JSON_TRANSITIONS(6),  JSON_TRANSITIONS(7),
+  JSON_TRANSITIONS(8),  JSON_TRANSITIONS(9),  JSON_TRANSITIONS(10), JSON_TRANSITIONS(11),
+  JSON_TRANSITIONS(12), JSON_TRANSITIONS(13), JSON_TRANSITIONS(14), JSON_TRANSITIONS(15),
+  JSON_TRANSITIONS(16), JSON_TRANSITIONS(17), JSON_TRANSITIONS(18), JSON_TRANSITIONS(19),
+  JSON_TRANSITIONS(20), JSON_TRANSITIONS(21), JSON_TRANSITIONS(22), JSON_TRANSITIONS(23),
+  JSON_TRANSITIONS(24), JSON_TRANSITIONS(25), JSON_TRANSITIONS(26), JSON_TRANSITIONS(27),
+  JSON_TRANSITIONS(28), JSON_TRANSITIONS(29)
+};
+
+// digits leave the number states unchanged, so runs of them can be
+// appended to the buffer without going through the table
+static_assert(transitions[STATE_IN_NUMBER][byteClasses['0']] == STATE_IN_NUMBER
+              && transitions[STATE_NUMBER_FRACTION][byteClasses['9']] == STATE_NUMBER_FRACTION
+              && transitions[STATE_NUMBER_EXPONENT][byteClasses['5']] == STATE_NUMBER_EXPONENT,
+              "digits stay in the number states");
+
+JsonStreamingParserBase::JsonStreamingParserBase(char* buffer, int bufferSize, JsonStackEntry* stack, int stackSize,
+                                                 ElementSelector* selectors, int pathDepth, char* keys, int keyLength)
+    : path(selectors, pathDepth, keys, pathDepth * keyLength) {
+    this->buffer = buffer;
+    this->bufferSize = bufferSize < 65535 ? bufferSize : 65535;
+    this->stack = stack;
+    this->stackSize = stackSize < 255 ? stackSize : 255;
+#ifdef JSON_PARSER_STATS
+    stats.clear();
+#endif
     reset();
 }
 
-void JsonStreamingParser::reset() {
+void JsonStreamingParserBase::reset() {
     state = STATE_START_DOCUMENT;
+    path.reset();
+    releaseScratch();
     bufferPos = 0;
-    unicodeEscapeBufferPos = 0;
-    unicodeBufferPos = 0;
+    unicodeValue = 0;
+    unicodeDigits = 0;
     characterCounter = 0;
+    sourceOrigin = 0;
+    stringSource = nullptr;
+    skipDepth = 0;
+    skipRequested = false;
+    skipInString = false;
+    skipEscape = false;
     stackPos = 0;
-    hasError = false;
+    activeBatch = nullptr;
+    for (JsonNumberBatch* batch = numberBatches; batch != nullptr; batch = batch->next) {
+      batch->count = 0;
+    }
+    errorCode = JSON_ERROR_NONE;
+    documentEnded = false;
     errorMessage = nullptr;
 }
 
-void JsonStreamingParser::setHandler(JsonHandler* handler) {
+void JsonStreamingParserBase::addNumberBatch(JsonNumberBatch* batch) {
+    // registering it twice would loop the list
+    removeNumberBatch(batch);
+    batch->count = 0;
+    batch->next = numberBatches;
+    numberBatches = batch;
+}
+
+void JsonStreamingParserBase::removeNumberBatch(JsonNumberBatch* batch) {
+    for (JsonNumberBatch** link = &numberBatches; *link != nullptr; link = &(*link)->next) {
+      if (*link == batch) {
+        if (activeBatch == batch) {
+          flushNumberBatch();
+          activeBatch = nullptr;
+        }
+        *link = batch->next;
+        batch->next = nullptr;
+        return;
+      }
+    }
+}
+
+void JsonStreamingParserBase::clearNumberBatches() {
+    flushNumberBatch();
+    activeBatch = nullptr;
+    while (numberBatches != nullptr) {
+      JsonNumberBatch* batch = numberBatches;
+      numberBatches = batch->next;
+      batch->next = nullptr;
+    }
+}
+
+void JsonStreamingParserBase::setHandler(JsonHandler* handler) {
   myHandler = handler;
 }
 
-void JsonStreamingParser::parse(char c) {
+void JsonStreamingParserBase::setBudget(JsonParserBudget* budget) {
+  this->budget = budget;
+  if (budget != nullptr) {
+    budget->start(characterCounter);
+  }
+}
+
+void JsonStreamingParserBase::setScratchPool(JsonScratchPool* pool) {
+  releaseScratch();
+  scratchPool = pool;
+  if (pool != nullptr) {
+    // from now on the buffer only exists while borrowed
+    buffer = nullptr;
+    bufferSize = 0;
+  }
+}
+
+bool JsonStreamingParserBase::acquireScratch() {
+  if (scratchPool == nullptr) {
+    return true;
+  }
+  if (buffer == nullptr) {
+    buffer = scratchPool->acquire();
+    if (buffer == nullptr) {
+      setError("Scratch pool exhausted", JSON_ERROR_CAPACITY);
+      return false;
+    }
+    bufferSize = scratchPool->getBufferSize();
+  }
+  return true;
+}
+
+void JsonStreamingParserBase::releaseScratch() {
+  if (scratchPool != nullptr && buffer != nullptr) {
+    scratchPool->release(buffer);
+    buffer = nullptr;
+    bufferSize = 0;
+  }
+}
+
+void JsonStreamingParserBase::parse(char c) {
+    sourceOrigin = 0;
+    stringSource = nullptr;
+    if (budget != nullptr && budgetSlice(1) == 0) {
+      return;
+    }
+    JSON_STATS_TIMER_START(parseStart);
+    consume(c);
+    JSON_STATS_TIMER_STOP(parseStart, totalCycles);
+  }
+
+void JsonStreamingParserBase::consume(char c) {
     // Early return if we have an error
-    if (hasError) {
+    if (errorCode != JSON_ERROR_NONE) {
         return;
     }
     
     // Check for stack overflow
-    if (stackPos >= JSON_PARSER_STACK_MAX_DEPTH - 1) {
-        hasError = true;
-        errorMessage = "Stack overflow - JSON too deeply nested";
+    if (stackPos >= stackSize - 1) {
+        setError("Stack overflow - JSON too deeply nested", JSON_ERROR_CAPACITY);
         return;
     }
 	
+    documentEnded = false;
+
+    // counted up front so that skipped whitespace is included: the count
+    // is the byte offset to resume a download from (see saveState)
+    characterCounter++;
+
 #ifdef ARDUINO_ARCH_ESP8266	
 	yield(); // reduce crashes
+	JSON_STATS_COUNT(yields);
 #endif	
-	
-    //System.out.print(c);
-    // valid whitespace characters in JSON (from RFC4627 for JSON) include:
-    // space, horizontal tab, line feed or new line, and carriage return.
-    // thanks:
-    // http://stackoverflow.com/questions/16042274/definition-of-whitespace-in-json
-    if ((c == ' ' || c == '\t' || c == '\n' || c == '\r')
-        && !(state == STATE_IN_STRING || state == STATE_UNICODE || state == STATE_START_ESCAPE
-            || state == STATE_IN_NUMBER || state == STATE_START_DOCUMENT)) {
-      return;
+
+    JSON_STATS_STATE(state);
+    if (skipDepth > 0) {
+      skipChar(c);
+    } else {
+      parseChar(c);
     }
-    switch (state) {
-    case STATE_IN_STRING:
-      if (c == '"') {
-        endString();
-      } else if (c == '\\') {
-        state = STATE_START_ESCAPE;
-      } else if ((c < 0x1f) || (c == 0x7f)) {
-        hasError = true;
-        errorMessage = "Unescaped control character in string";
-        return;
-      } else {
-        if (hasError) return; // Check if buffer overflow occurred
+  }
+
+size_t JsonStreamingParserBase::parse(const char* data, size_t length) {
+    return parse(data, length, nullptr);
+  }
+
+bool JsonStreamingParserBase::validate(const char* data, size_t length) {
+    bool wasValidateOnly = validateOnly;
+    reset();
+    validateOnly = true;
+    size_t consumed = parse(data, length);
+    validateOnly = wasValidateOnly;
+    if (errorCode != JSON_ERROR_NONE) {
+      return false;
+    }
+    // errors past the parsed bytes are counted up to the byte at fault
+    if (!documentEnded) {
+      characterCounter = length + 1;
+      setError("Unexpected end of document");
+      return false;
+    }
+    for (size_t i = consumed; i < length; i++) {
+      if (data[i] != ' ' && data[i] != '\t' && data[i] != '\n' && data[i] != '\r') {
+        characterCounter = i + 1;
+        setError("Unexpected data after document");
+        return false;
+      }
+    }
+    return true;
+  }
+
+size_t JsonStreamingParserBase::parse(const char* data, size_t length, const char* source) {
+    if (budget == nullptr) {
+      return parseRun(data, length, source);
+    }
+    // parsed in slices up to the next budget check
+    size_t i = 0;
+    documentEnded = false;
+    while (i < length && errorCode == JSON_ERROR_NONE && !documentEnded) {
+      size_t slice = budgetSlice(length - i);
+      if (slice == 0) {
+        break;
+      }
+      i += parseRun(data + i, slice, source != nullptr ? source + i : nullptr);
+    }
+    return i;
+  }
+
+/*
+  How many of length bytes may be parsed before the budget is checked
+  again, 0 (with the error set) once it is spent. The byte limit is exact;
+  the clock is read every JSON_PARSER_BUDGET_INTERVAL bytes.
+*/
+size_t JsonStreamingParserBase::budgetSlice(size_t length) {
+    if (errorCode != JSON_ERROR_NONE) {
+      return 0;
+    }
+    if (characterCounter == 0) {
+      budget->start(0);
+    }
+    if (budget->maxBytes > 0 && characterCounter >= budget->maxBytes) {
+      // the offset names the byte refused
+      characterCounter++;
+      setError("Budget exceeded - document too large", JSON_ERROR_BUDGET_BYTES);
+      return 0;
+    }
+    if (characterCounter >= budget->nextCheck) {
+      if (budget->maxMillis > 0 && millis() - budget->startMillis >= budget->maxMillis) {
+        setError("Budget exceeded - parsing took too long", JSON_ERROR_BUDGET_TIME);
+        return 0;
+      }
+      budget->nextCheck = characterCounter + JSON_PARSER_BUDGET_INTERVAL;
+    }
+    uint32_t slice = budget->nextCheck - characterCounter;
+    if (budget->maxBytes > 0 && budget->maxBytes - characterCounter < slice) {
+      slice = budget->maxBytes - characterCounter;
+    }
+    return slice < length ? slice : length;
+  }
+
+bool JsonStreamingParserBase::spendEvent() {
+    budget->events++;
+    if (budget->maxEvents > 0 && budget->events > budget->maxEvents) {
+      setError("Budget exceeded - too many events", JSON_ERROR_BUDGET_EVENTS);
+      return false;
+    }
+    return true;
+  }
+
+/*
+  Largest bufferPos a string or number may reach: the buffer's, or the
+  budget's string length if shorter.
+*/
+int JsonStreamingParserBase::tokenLimit() const {
+    int limit = bufferSize - 1;
+    if (budget != nullptr && budget->maxStringLength > 0 && budget->maxStringLength < limit) {
+      limit = budget->maxStringLength;
+    }
+    return limit;
+  }
+
+size_t JsonStreamingParserBase::parseRun(const char* data, size_t length, const char* source) {
+    uintptr_t origin = source != nullptr ? (uintptr_t) source - characterCounter : 0;
+    if (origin != sourceOrigin) {
+      // not where the previous input left off
+      stringSource = nullptr;
+    }
+    sourceOrigin = origin;
+
+    // timed as a whole: the runs below bypass consume(), and skipChar()
+    // may end in a handler call
+    JSON_STATS_TIMER_START(parseStart);
+    size_t i = 0;
+    documentEnded = false;
+    while (i < length && errorCode == JSON_ERROR_NONE && !documentEnded) {
+      // skipped subtrees are only scanned for their end
+      while (skipDepth > 0 && i < length) {
+        characterCounter++;
+        JSON_STATS_STATE(state);
+        skipChar(data[i++]);
+      }
+      if (i == length) {
+        break;
+      }
+      // validation only counts the plain bytes of strings
+      while (validateOnly && state == STATE_IN_STRING && i < length && bufferPos + 8 < tokenLimit()
+             && stackPos < stackSize - 1) {
+        size_t run;
+#if JSON_PARSER_SWAR
+        if (length - i >= 8 && jsonIsEightStringBytes(jsonLoadEightBytes(data + i))) {
+          run = 8;
+        } else
+#endif
+        if (transitions[STATE_IN_STRING][byteClasses[(uint8_t) data[i]]] == STATE_IN_STRING) {
+          run = 1;
+        } else {
+          break;
+        }
+        bufferPos += run;
+        characterCounter += run;
+        i += run;
+        JSON_STATS_STATE_BYTES(state, run);
+        JSON_STATS_MAX(maxBufferFill, bufferPos);
+      }
+      if (i == length) {
+        break;
+      }
+#if JSON_PARSER_SWAR
+      // runs of 8 digits inside a number are copied in one go
+      while ((state == STATE_IN_NUMBER || state == STATE_NUMBER_FRACTION || state == STATE_NUMBER_EXPONENT)
+             && length - i >= 8 && bufferPos + 8 < tokenLimit() && jsonIsEightDigits(jsonLoadEightBytes(data + i))) {
+        memcpy(buffer + bufferPos, data + i, 8);
+        bufferPos += 8;
+        characterCounter += 8;
+        i += 8;
+        JSON_STATS_STATE_BYTES(state, 8);
+        JSON_STATS_MAX(maxBufferFill, bufferPos);
+      }
+      if (i == length) {
+        break;
+      }
+#endif
+      consume(data[i++]);
+    }
+    JSON_STATS_TIMER_STOP(parseStart, totalCycles);
+    return i;
+  }
+
+void JsonStreamingParserBase::parseChar(char c) {
+    uint8_t next = transitions[state][byteClasses[(uint8_t) c]];
+    if (next < JSON_PARSER_STATE_COUNT) {
+      if (next >= STATE_IN_STRING) {
         buffer[bufferPos] = c;
         increaseBufferPointer();
+      } else if (doEmitWhitespace && next == state && !validateOnly) {
+        // only whitespace keeps a state below the token states
+        myHandler->whitespace(c);
       }
+      state = (JsonParserState) next;
+      return;
+    }
+    runAction(next, c);
+  }
+
+void JsonStreamingParserBase::skipChar(char c) {
+    if (skipInString) {
+      if (skipEscape) {
+        skipEscape = false;
+      } else if (c == '\\') {
+        skipEscape = true;
+      } else if (c == '"') {
+        skipInString = false;
+      }
+      return;
+    }
+    switch (c) {
+    case '"':
+      skipInString = true;
       break;
-    case STATE_IN_ARRAY:
-      if (c == ']') {
-        endArray();
-      } else {
-        path.getCurrent()->step();
-        startValue(c);
+    case '{':
+    case '[':
+      if (++skipDepth == 0) {
+        setError("Stack overflow - JSON too deeply nested", JSON_ERROR_CAPACITY);
       }
       break;
-    case STATE_IN_OBJECT:
-      if (c == '}') {
-        endObject();
-      } else if (c == '"') {
-        startKey();
-      } else {
-        hasError = true;
-        errorMessage = "Expected start of string for object key";
-        return;
+    case '}':
+    case ']':
+      if (--skipDepth == 0) {
+        // the end of the skipped object or array is parsed as usual
+        parseChar(c);
       }
       break;
-    case STATE_END_KEY:
-      if (c != ':') {
-        hasError = true;
-        errorMessage = "Expected ':' after object key";
-        return;
+    }
+  }
+
+void JsonStreamingParserBase::runAction(uint8_t action, char c) {
+    if (budget != nullptr && action <= ACTION_END_NULL && ((EVENT_ACTIONS >> (action - ACTION_START_OBJECT)) & 1)
+        && !spendEvent()) {
+      return;
+    }
+    switch (action) {
+    case ACTION_START_OBJECT:
+      if (state == STATE_START_DOCUMENT && !validateOnly) {
+        JSON_STATS_HANDLER(JSON_EVENT_START_DOCUMENT, myHandler->startDocument());
+      }
+      startObject();
+      break;
+    case ACTION_END_OBJECT:
+      if (state == STATE_AFTER_VALUE && stack[stackPos - 1] != STACK_OBJECT) {
+        // a closer not matching the open container
+        setError("Expected ',' or ']' while parsing array");
+        break;
       }
-      state = STATE_AFTER_KEY;
+      endObject();
+      break;
+    case ACTION_START_ARRAY:
+      if (state == STATE_START_DOCUMENT && !validateOnly) {
+        JSON_STATS_HANDLER(JSON_EVENT_START_DOCUMENT, myHandler->startDocument());
+      }
+      startArray();
+      break;
+    case ACTION_END_ARRAY:
+      if (state == STATE_AFTER_VALUE && stack[stackPos - 1] != STACK_ARRAY) {
+        setError("Expected ',' or '}' while parsing object");
+        break;
+      }
+      endArray();
+      break;
+    case ACTION_START_KEY:
+      startKey();
+      break;
+    case ACTION_START_STRING:
+      startString();
+      break;
+    case ACTION_END_STRING:
+      endString();
+      break;
+    case ACTION_START_NUMBER:
+      startNumber(c);
       break;
-    case STATE_AFTER_KEY:
-      startValue(c);
+    case ACTION_END_NUMBER:
+      endNumber();
+      // we have consumed one beyond the end of the number
+      parseChar(c);
       break;
-    case STATE_START_ESCAPE:
+    case ACTION_END_TRUE:
+      endTrue();
+      break;
+    case ACTION_END_FALSE:
+      endFalse();
+      break;
+    case ACTION_END_NULL:
+      endNull();
+      break;
+    case ACTION_ESCAPE:
       processEscapeCharacters(c);
       break;
-    case STATE_UNICODE:
+    case ACTION_UNICODE:
       processUnicodeCharacter(c);
       break;
-    case STATE_UNICODE_SURROGATE:
-      unicodeEscapeBuffer[unicodeEscapeBufferPos] = c;
-      unicodeEscapeBufferPos++;
-      if (unicodeEscapeBufferPos == 2) {
+    case ACTION_UNICODE_SURROGATE:
+      unicodeDigits++;
+      if (unicodeDigits == 2) {
         endUnicodeSurrogateInterstitial();
       }
       break;
-    case STATE_AFTER_VALUE: {
+    case ACTION_NEXT_VALUE: {
       // not safe for size == 0!!!
-      int within = stack[stackPos - 1];
+      JsonStackEntry within = stack[stackPos - 1];
       if (within == STACK_OBJECT) {
-        if (c == '}') {
-          endObject();
-        } else if (c == ',') {
-          state = STATE_IN_OBJECT;
-        } else {
-          hasError = true;
-          errorMessage = "Expected ',' or '}' while parsing object";
-          return;
-        }
+        state = STATE_OBJECT_NEXT;
       } else if (within == STACK_ARRAY) {
-        if (c == ']') {
-          endArray();
-        } else if (c == ',') {
-          state = STATE_IN_ARRAY;
-        } else {
-          hasError = true;
-          errorMessage = "Expected ',' or ']' while parsing array";
-          return;
+        if (!validateOnly) {
+          path.getCurrent()->step();
         }
+        state = STATE_ARRAY_NEXT;
       } else {
-        hasError = true;
-        errorMessage = "Finished literal but unclear what state to move to";
-        return;
+        setError("Finished literal but unclear what state to move to");
       }
-    }break;
-    case STATE_IN_NUMBER:
-      if (c >= '0' && c <= '9') {
-        buffer[bufferPos] = c;
-        increaseBufferPointer();
-      } else if (c == '.') {
-        if (doesCharArrayContain(buffer, bufferPos, '.')) {
-          hasError = true;
-          errorMessage = "Cannot have multiple decimal points in number";
-          return;
-        } else if (doesCharArrayContain(buffer, bufferPos, 'e')) {
-          hasError = true;
-          errorMessage = "Cannot have decimal point in exponent";
-          return;
-        }
-        buffer[bufferPos] = c;
-        increaseBufferPointer();
-      } else if (c == 'e' || c == 'E') {
-        if (doesCharArrayContain(buffer, bufferPos, 'e')) {
-          hasError = true;
-          errorMessage = "Cannot have multiple exponents in number";
-          return;
-        }
-        buffer[bufferPos] = c;
-        increaseBufferPointer();
-      } else if (c == '+' || c == '-') {
-        if (bufferPos <= 0) {
-          hasError = true;
-          errorMessage = "Invalid number format";
-          return;
-        }
-        char last = buffer[bufferPos - 1];
-        if (!(last == 'e' || last == 'E')) {
-          hasError = true;
-          errorMessage = "Can only have '+' or '-' after 'e' or 'E' in number";
-          return;
-        }
-        buffer[bufferPos] = c;
-        increaseBufferPointer();
+    } break;
+    case ACTION_AFTER_VALUE_ERROR:
+      if (stack[stackPos - 1] == STACK_OBJECT) {
+        setError("Expected ',' or '}' while parsing object");
       } else {
-        endNumber();
-        // we have consumed one beyond the end of the number
-        parse(c);
-      }
-      break;
-    case STATE_IN_TRUE:
-      buffer[bufferPos] = c;
-      increaseBufferPointer();
-      if (bufferPos == 4) {
-        endTrue();
-      }
-      break;
-    case STATE_IN_FALSE:
-      buffer[bufferPos] = c;
-      increaseBufferPointer();
-      if (bufferPos == 5) {
-        endFalse();
+        setError("Expected ',' or ']' while parsing array");
       }
       break;
-    case STATE_IN_NULL:
-      buffer[bufferPos] = c;
-      increaseBufferPointer();
-      if (bufferPos == 4) {
-        endNull();
-      }
+    default:
+      setError(errorMessages[action - ERROR_DOCUMENT_START]);
       break;
-    case STATE_START_DOCUMENT:
-      myHandler->startDocument();
-      if (c == '[') {
-        startArray();
-      } else if (c == '{') {
-        startObject();
-      } else {
-        hasError = true;
-        errorMessage = "Document must start with object or array";
-        return;
-      }
-      break;
-    //case STATE_DONE:
-      // throw new ParsingError($this->_line_number, $this->_char_number,
-      // "Expected end of document.");
-    //default:
-      // throw new ParsingError($this->_line_number, $this->_char_number,
-      // "Internal error. Reached an unknown state: ".$this->_state);
     }
-    characterCounter++;
   }
 
-void JsonStreamingParser::increaseBufferPointer() {
-  if (bufferPos >= JSON_PARSER_BUFFER_MAX_LENGTH - 1) {
-    hasError = true;
-    errorMessage = "Buffer overflow - JSON string/number too long";
+void JsonStreamingParserBase::setError(const char* message, JsonParserError code) {
+  errorCode = code;
+  errorMessage = message;
+}
+
+void JsonStreamingParserBase::increaseBufferPointer() {
+  if (bufferPos >= bufferSize - 1) {
+    setError("Buffer overflow - JSON string/number too long", JSON_ERROR_CAPACITY);
+    return;
+  }
+  if (budget != nullptr && budget->maxStringLength > 0 && bufferPos >= budget->maxStringLength) {
+    setError("Budget exceeded - string/number too long", JSON_ERROR_BUDGET_STRING);
     return;
   }
   bufferPos++;
+  JSON_STATS_MAX(maxBufferFill, bufferPos);
 }
 
-void JsonStreamingParser::endString() {
-    int popped = stack[stackPos - 1];
+void JsonStreamingParserBase::endString() {
+    JsonStackEntry popped = stack[stackPos - 1];
     stackPos--;
     if (popped == STACK_KEY) {
-      buffer[bufferPos] = '\0';
-      path.getCurrent()->set(buffer);
-      state = STATE_END_KEY;
+      if (validateOnly || path.setKey(buffer, bufferPos)) {
+        JSON_STATS_COUNT(keys);
+        state = STATE_END_KEY;
+      } else {
+        setError("Path overflow - keys too long", JSON_ERROR_CAPACITY);
+      }
+    } else if (popped == STACK_STRING && validateOnly) {
+      state = STATE_AFTER_VALUE;
     } else if (popped == STACK_STRING) {
       buffer[bufferPos] = '\0';
-      myHandler->value(path, elementValue.with(buffer));
+      // escapes make the source text longer than the buffered one
+      const char* source = stringSource;
+      if (source != nullptr && (const char*) (sourceOrigin + characterCounter - 1) - source != bufferPos) {
+        source = nullptr;
+      }
+      JSON_STATS_COUNT(strings);
+      flushNumberBatch();
+      JSON_STATS_HANDLER(JSON_EVENT_VALUE, myHandler->value(path, elementValue.withString(buffer, bufferPos, source)));
       state = STATE_AFTER_VALUE;
     } else {
       // throw new ParsingError($this->_line_number, $this->_char_number,
       // "Unexpected end of string.");
     }
     bufferPos = 0;
-  }
-void JsonStreamingParser::startValue(char c) {
-	
-#ifdef ARDUINO_ARCH_ESP8266	
-	yield();
-#endif
-	
-    if (c == '[') {
-      startArray();
-    } else if (c == '{') {
-      startObject();
-    } else if (c == '"') {
-      startString();
-    } else if (isDigit(c)) {
-      startNumber(c);
-    } else if (c == 't') {
-      state = STATE_IN_TRUE;
-      buffer[bufferPos] = c;
-      increaseBufferPointer();
-    } else if (c == 'f') {
-      state = STATE_IN_FALSE;
-      buffer[bufferPos] = c;
-      increaseBufferPointer();
-    } else if (c == 'n') {
-      state = STATE_IN_NULL;
-      buffer[bufferPos] = c;
-      increaseBufferPointer();
-    } else {
-      hasError = true;
-      errorMessage = "Unexpected character for value";
-      return;
-    }
-  }
-
-boolean JsonStreamingParser::isDigit(char c) {
-    // Only concerned with the first character in a number.
-    return (c >= '0' && c <= '9') || c == '-';
+    releaseScratch();
   }
 
-void JsonStreamingParser::endArray() {
+void JsonStreamingParserBase::endArray() {
     if (stackPos <= 0) {
-      hasError = true;
-      errorMessage = "Unexpected end of array - stack underflow";
+      setError("Unexpected end of array - stack underflow");
       return;
     }
-    int popped = stack[stackPos - 1];
+    if (activeBatch != nullptr && stackPos == batchDepth) {
+      flushNumberBatch();
+      activeBatch = nullptr;
+    }
+    JsonStackEntry popped = stack[stackPos - 1];
     stackPos--;
-    path.pop();
+    if (!validateOnly) {
+      path.pop();
+    }
     if (popped != STACK_ARRAY) {
-      hasError = true;
-      errorMessage = "Unexpected end of array encountered";
+      setError("Unexpected end of array encountered");
       return;
     }
-    myHandler->endArray(path);
+    if (!validateOnly) {
+      JSON_STATS_HANDLER(JSON_EVENT_END_ARRAY, myHandler->endArray(path));
+    }
     state = STATE_AFTER_VALUE;
     if (stackPos == 0) {
       endDocument();
     }
   }
 
-void JsonStreamingParser::startKey() {
+void JsonStreamingParserBase::startKey() {
+    if (!acquireScratch()) return;
     stack[stackPos] = STACK_KEY;
     stackPos++;
     state = STATE_IN_STRING;
   }
 
-void JsonStreamingParser::endObject() {
+void JsonStreamingParserBase::endObject() {
     if (stackPos <= 0) {
-      hasError = true;
-      errorMessage = "Unexpected end of object - stack underflow";
+      setError("Unexpected end of object - stack underflow");
       return;
     }
-    int popped = stack[stackPos];
+    JsonStackEntry popped = stack[stackPos - 1];
     stackPos--;
-    path.pop();
+    if (!validateOnly) {
+      path.pop();
+    }
     if (popped != STACK_OBJECT) {
-      hasError = true;
-      errorMessage = "Unexpected end of object encountered";
+      setError("Unexpected end of object encountered");
       return;
     }
-    myHandler->endObject(path);
+    if (!validateOnly) {
+      JSON_STATS_HANDLER(JSON_EVENT_END_OBJECT, myHandler->endObject(path));
+    }
     state = STATE_AFTER_VALUE;
     if (stackPos == 0) {
       endDocument();
     }
   }
 
-void JsonStreamingParser::processEscapeCharacters(char c) {
+void JsonStreamingParserBase::processEscapeCharacters(char c) {
     if (c == '"') {
       buffer[bufferPos] = '"';
       increaseBufferPointer();
@@ -358,197 +868,252 @@ void JsonStreamingParser::processEscapeCharacters(char c) {
     } else if (c == 't') {
       buffer[bufferPos] = '\t';
       increaseBufferPointer();
-    } else if (c == 'u') {
-      state = STATE_UNICODE;
-    } else {
-      hasError = true;
-      errorMessage = "Expected escaped character after backslash";
-      return;
-    }
-    if (state != STATE_UNICODE) {
-      state = STATE_IN_STRING;
     }
+    // \u and invalid escapes are dispatched by the transition table
+    state = STATE_IN_STRING;
   }
 
-void JsonStreamingParser::processUnicodeCharacter(char c) {
+void JsonStreamingParserBase::processUnicodeCharacter(char c) {
     if (!isHexCharacter(c)) {
-      hasError = true;
-      errorMessage = "Expected hex character for escaped Unicode character";
+      setError("Expected hex character for escaped Unicode character");
       return;
     }
 
-    unicodeBuffer[unicodeBufferPos] = c;
-    unicodeBufferPos++;
-
-    if (unicodeBufferPos == 4) {
-      int codepoint = getHexArrayAsDecimal(unicodeBuffer, unicodeBufferPos);
-      endUnicodeCharacter(codepoint);
-      return;
-      /*if (codepoint >= 0xD800 && codepoint < 0xDC00) {
-        unicodeHighSurrogate = codepoint;
-        unicodeBufferPos = 0;
-        state = STATE_UNICODE_SURROGATE;
-      } else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
-        if (unicodeHighSurrogate == -1) {
-          // throw new ParsingError($this->_line_number,
-          // $this->_char_number,
-          // "Missing high surrogate for Unicode low surrogate.");
-        }
-        int combinedCodePoint = ((unicodeHighSurrogate - 0xD800) * 0x400) + (codepoint - 0xDC00) + 0x10000;
-        endUnicodeCharacter(combinedCodePoint);
-      } else if (unicodeHighSurrogate != -1) {
-        // throw new ParsingError($this->_line_number,
-        // $this->_char_number,
-        // "Invalid low surrogate following Unicode high surrogate.");
-        endUnicodeCharacter(codepoint);
-      } else {
-        endUnicodeCharacter(codepoint);
-      }*/
+    uint8_t digit;
+    if (c >= 'a') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A') {
+      digit = c - 'A' + 10;
+    } else {
+      digit = c - '0';
     }
-  }
-boolean JsonStreamingParser::isHexCharacter(char c) {
-    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
-  }
+    unicodeValue = (unicodeValue << 4) | digit;
+    unicodeDigits++;
 
-int JsonStreamingParser::getHexArrayAsDecimal(char hexArray[], int length) {
-    int result = 0;
-    for (int i = length; i >= 0; i--) {
-      char current = hexArray[length - i - 1];
-      int value = 0;
-      if (current >= 'a' && current <= 'f') {
-        value = current - 'a' + 10;
-      } else if (current >= 'A' && current <= 'F') {
-        value = current - 'A' + 10;
-      } else if (current >= '0' && current <= '9') {
-        value = current - '0';
-      }
-      result = (result << 4) | value;
+    if (unicodeDigits == 4) {
+      endUnicodeCharacter(unicodeValue);
     }
-    return result;
   }
 
-boolean JsonStreamingParser::doesCharArrayContain(char myArray[], int length, char c) {
-    for (int i = 0; i < length; i++) {
-      if (myArray[i] == c) {
-        return true;
-      }
-    }
-    return false;
+boolean JsonStreamingParserBase::isHexCharacter(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
   }
 
-void JsonStreamingParser::endUnicodeSurrogateInterstitial() {
-    char unicodeEscape = unicodeEscapeBuffer[unicodeEscapeBufferPos - 1];
-    if (unicodeEscape != 'u') {
-      // throw new ParsingError($this->_line_number, $this->_char_number,
-      // "Expected '\\u' following a Unicode high surrogate. Got: " .
-      // $unicode_escape);
-    }
-    unicodeBufferPos = 0;
-    unicodeEscapeBufferPos = 0;
+void JsonStreamingParserBase::endUnicodeSurrogateInterstitial() {
+    unicodeValue = 0;
+    unicodeDigits = 0;
     state = STATE_UNICODE;
   }
 
-void JsonStreamingParser::endNumber() {
+// number states that end an integer
+static bool isIntegerState(uint8_t state) {
+  return state == STATE_IN_NUMBER || state == STATE_NUMBER_ZERO;
+}
+
+void JsonStreamingParserBase::endNumber() {
     buffer[bufferPos] = '\0';
-    if (strchr(buffer, '.') != NULL) {
-      float floatValue;
-      sscanf(buffer, "%f", &floatValue);
-      myHandler->value(path, elementValue.with(floatValue));
+    JSON_STATS_COUNT(numbers);
+    if (validateOnly) {
+      // nothing to deliver
+    } else if (activeBatch != nullptr && stackPos == batchDepth && addToBatch()) {
+      // collected, delivered with the batch
     } else {
-      long intValue;
-      sscanf(buffer, "%ld", &intValue);
-      myHandler->value(path, elementValue.with(intValue));
+      // converted only if the handler asks for the value; the state tells
+      // integers from numbers with a fraction or an exponent
+      JSON_STATS_HANDLER(JSON_EVENT_VALUE, myHandler->value(path, elementValue.withNumber(buffer, bufferPos, isIntegerState(state))));
     }
     bufferPos = 0;
+    releaseScratch();
     state = STATE_AFTER_VALUE;
   }
 
-int JsonStreamingParser::convertDecimalBufferToInt(char myArray[], int length) {
-    int result = 0;
-    for (int i = 0; i < length; i++) {
-      char current = myArray[length - i - 1];
-      result += (current - '0') * 10;
+/*
+  Converts the number in buffer into the active batch. Returns false,
+  after delivering the values collected so far, if it does not fit the
+  batch type.
+*/
+bool JsonStreamingParserBase::addToBatch() {
+    JsonNumberBatch* batch = activeBatch;
+    if (batch->type == JSON_BATCH_INT32 && !isIntegerState(state)) {
+      flushNumberBatch();
+      return false;
+    }
+    if (batch->count == 0) {
+      batch->firstIndex = path.getIndex();
+    }
+    if (batch->type == JSON_BATCH_INT32) {
+      ((int32_t*) batch->data)[batch->count] = (int32_t) jsonParseInteger(buffer, bufferPos);
+    } else if (batch->type == JSON_BATCH_FIXED) {
+      int64_t mantissa;
+      int exponent;
+      jsonParseDecimal(buffer, bufferPos, &mantissa, &exponent);
+      int64_t value = jsonScaleDecimal(mantissa, exponent, batch->scale);
+      ((int32_t*) batch->data)[batch->count] = value > INT32_MAX ? INT32_MAX : value < INT32_MIN ? INT32_MIN : (int32_t) value;
+    } else if (batch->type == JSON_BATCH_FLOAT) {
+      ((float*) batch->data)[batch->count] = jsonParseFloat(buffer);
+    } else {
+      ((double*) batch->data)[batch->count] = jsonParseDouble(buffer);
+    }
+    if (++batch->count == batch->capacity) {
+      deliverBatch();
     }
-    return result;
+    return true;
   }
 
-void JsonStreamingParser::endDocument() {
-    myHandler->endDocument();
+/*
+  Hands the active batch to the handler, with the path pointing to its
+  first element.
+*/
+void JsonStreamingParserBase::deliverBatch() {
+    JsonNumberBatch* batch = activeBatch;
+    ElementSelector* current = path.getCurrent();
+    int index = current->index;
+    current->index = batch->firstIndex;
+    if (batch->type == JSON_BATCH_INT32 || batch->type == JSON_BATCH_FIXED) {
+      JSON_STATS_HANDLER(JSON_EVENT_VALUE, myHandler->values(path, (const int32_t*) batch->data, batch->count, batch->firstIndex));
+    } else if (batch->type == JSON_BATCH_FLOAT) {
+      JSON_STATS_HANDLER(JSON_EVENT_VALUE, myHandler->values(path, (const float*) batch->data, batch->count, batch->firstIndex));
+    } else {
+      JSON_STATS_HANDLER(JSON_EVENT_VALUE, myHandler->values(path, (const double*) batch->data, batch->count, batch->firstIndex));
+    }
+    current->index = index;
+    batch->count = 0;
+  }
+
+void JsonStreamingParserBase::endDocument() {
+    if (!validateOnly) {
+      JSON_STATS_HANDLER(JSON_EVENT_END_DOCUMENT, myHandler->endDocument());
+    }
     state = STATE_START_DOCUMENT;
+    documentEnded = true;
     bufferPos = 0;
-    unicodeEscapeBufferPos = 0;
-    unicodeBufferPos = 0;
+    unicodeValue = 0;
+    unicodeDigits = 0;
     characterCounter = 0;
   }
 
-void JsonStreamingParser::endTrue() {
-    buffer[bufferPos] = '\0';
-    if(strcmp(buffer, "true") == 0) {
-      myHandler->value(path, elementValue.with(true));
-    } else {
-      hasError = true;
-      errorMessage = "Expected 'true' literal";
-      return;
+void JsonStreamingParserBase::endTrue() {
+    if (!validateOnly) {
+      flushNumberBatch();
+      JSON_STATS_HANDLER(JSON_EVENT_VALUE, myHandler->value(path, elementValue.with(true)));
     }
-    bufferPos = 0;
     state = STATE_AFTER_VALUE;
   }
 
-void JsonStreamingParser::endFalse() {
-    buffer[bufferPos] = '\0';
-    if(strcmp(buffer, "false") == 0) {
-      myHandler->value(path, elementValue.with(false));
-    } else {
-      hasError = true;
-      errorMessage = "Expected 'false' literal";
-      return;
+void JsonStreamingParserBase::endFalse() {
+    if (!validateOnly) {
+      flushNumberBatch();
+      JSON_STATS_HANDLER(JSON_EVENT_VALUE, myHandler->value(path, elementValue.with(false)));
     }
-    bufferPos = 0;
     state = STATE_AFTER_VALUE;
   }
 
-void JsonStreamingParser::endNull() {
-    buffer[bufferPos] = '\0';
-    if(strcmp(buffer, "null") == 0) {
-      myHandler->value(path, elementValue.with());
-    } else {
-      hasError = true;
-      errorMessage = "Expected 'null' literal";
-      return;
+void JsonStreamingParserBase::endNull() {
+    if (!validateOnly) {
+      flushNumberBatch();
+      JSON_STATS_HANDLER(JSON_EVENT_VALUE, myHandler->value(path, elementValue.with()));
     }
-    bufferPos = 0;
     state = STATE_AFTER_VALUE;
   }
 
-void JsonStreamingParser::startArray() {
-    myHandler->startArray(path);
+void JsonStreamingParserBase::startArray() {
+    if (budget != nullptr && budget->maxDepth > 0 && stackPos >= budget->maxDepth) {
+      setError("Budget exceeded - JSON too deeply nested", JSON_ERROR_BUDGET_DEPTH);
+      return;
+    }
+    if (validateOnly) {
+      // the depth a parse would track in its path
+      if (stackPos >= path.getCapacity()) {
+        setError("Path overflow - JSON too deeply nested", JSON_ERROR_CAPACITY);
+        return;
+      }
+      state = STATE_IN_ARRAY;
+      stack[stackPos++] = STACK_ARRAY;
+      return;
+    }
+    flushNumberBatch();
+    skipRequested = false;
+    JSON_STATS_HANDLER(JSON_EVENT_START_ARRAY, myHandler->startArray(path));
+    if (skipRequested) {
+      skipDepth = 1;
+      skipRequested = false;
+    }
     state = STATE_IN_ARRAY;
     stack[stackPos] = STACK_ARRAY;
-    path.push(); 
+    if (!path.push()) {
+      setError(path.getCount() < path.getCapacity() ? "Path overflow - keys too long"
+                                                    : "Path overflow - JSON too deeply nested",
+               JSON_ERROR_CAPACITY);
+      return;
+    }
+    // the index of the first element; ',' steps to the next one
+    path.getCurrent()->step();
     stackPos++;
+    JSON_STATS_MAX(maxDepth, stackPos);
+
+    if (numberBatches != nullptr) {
+      uint32_t hash = jsonPathHashOf(path);
+      for (JsonNumberBatch* batch = numberBatches; batch != nullptr; batch = batch->next) {
+        if (batch->pathHash == hash) {
+          activeBatch = batch;
+          batchDepth = stackPos;
+          break;
+        }
+      }
+    }
   }
 
-void JsonStreamingParser::startObject() {
-    myHandler->startObject(path);
+void JsonStreamingParserBase::startObject() {
+    if (budget != nullptr && budget->maxDepth > 0 && stackPos >= budget->maxDepth) {
+      setError("Budget exceeded - JSON too deeply nested", JSON_ERROR_BUDGET_DEPTH);
+      return;
+    }
+    if (validateOnly) {
+      // the depth a parse would track in its path
+      if (stackPos >= path.getCapacity()) {
+        setError("Path overflow - JSON too deeply nested", JSON_ERROR_CAPACITY);
+        return;
+      }
+      state = STATE_IN_OBJECT;
+      stack[stackPos++] = STACK_OBJECT;
+      return;
+    }
+    flushNumberBatch();
+    skipRequested = false;
+    JSON_STATS_HANDLER(JSON_EVENT_START_OBJECT, myHandler->startObject(path));
+    if (skipRequested) {
+      skipDepth = 1;
+      skipRequested = false;
+    }
     state = STATE_IN_OBJECT;
     stack[stackPos] = STACK_OBJECT;
-    path.push(); 
+    if (!path.push()) {
+      setError(path.getCount() < path.getCapacity() ? "Path overflow - keys too long"
+                                                    : "Path overflow - JSON too deeply nested",
+               JSON_ERROR_CAPACITY);
+      return;
+    }
     stackPos++;
+    JSON_STATS_MAX(maxDepth, stackPos);
   }
 
-void JsonStreamingParser::startString() {
+void JsonStreamingParserBase::startString() {
+    if (!acquireScratch()) return;
+    // the opening quote is byte characterCounter - 1
+    stringSource = sourceOrigin != 0 ? (const char*) (sourceOrigin + characterCounter) : nullptr;
     stack[stackPos] = STACK_STRING;
     stackPos++;
     state = STATE_IN_STRING;
   }
 
-void JsonStreamingParser::startNumber(char c) {
-    state = STATE_IN_NUMBER;
+void JsonStreamingParserBase::startNumber(char c) {
+    if (!acquireScratch()) return;
+    state = c == '-' ? STATE_NUMBER_MINUS : c == '0' ? STATE_NUMBER_ZERO : STATE_IN_NUMBER;
     buffer[bufferPos] = c;
     increaseBufferPointer();
   }
 
-void JsonStreamingParser::endUnicodeCharacter(int codepoint) {
+void JsonStreamingParserBase::endUnicodeCharacter(int codepoint) {
     if (codepoint < 0x80){
       buffer[bufferPos] = (char) (codepoint);
     } else if (codepoint <= 0x800){
@@ -561,7 +1126,221 @@ void JsonStreamingParser::endUnicodeCharacter(int codepoint) {
       buffer[bufferPos] = ' ';
     }
     increaseBufferPointer();
-    unicodeBufferPos = 0;
-    unicodeHighSurrogate = -1;
+    unicodeValue = 0;
+    unicodeDigits = 0;
     state = STATE_IN_STRING;
   }
+
+void JsonParserFootprint::print(Print& out) {
+    out.print("JsonStreamingParserBase: "); out.println((unsigned long) PARSER_BASE);
+    out.print("JsonStreamingParser:     "); out.println((unsigned long) PARSER);
+    out.print("ElementPath:             "); out.println((unsigned long) ELEMENT_PATH);
+    out.print("ElementSelector:         "); out.println((unsigned long) ELEMENT_SELECTOR);
+    out.print("ElementValue:            "); out.println((unsigned long) ELEMENT_VALUE);
+  }
+
+/*
+  State blob layout, little endian:
+    header    magic (2), version, state, stack depth, path depth, unicode
+              digits, buffer position (2), unicode value (2), byte offset (4),
+              skip depth (2), skip flags (in string 1, after backslash 2)
+    stack     one byte per entry
+    path      per level: index (4, -1 for object members), then for object
+              members the key length (1) and key
+    buffer    buffer position bytes
+    checksum  Fletcher-16 of all of the above (2)
+*/
+
+static uint8_t* putState16(uint8_t* p, uint16_t value) {
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+  return p + 2;
+}
+
+static uint8_t* putState32(uint8_t* p, uint32_t value) {
+  p = putState16(p, value & 0xFFFF);
+  return putState16(p, value >> 16);
+}
+
+static uint16_t getState16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t getState32(const uint8_t* p) {
+  return getState16(p) | ((uint32_t) getState16(p + 2) << 16);
+}
+
+static uint16_t stateChecksum(const uint8_t* data, size_t length) {
+  uint16_t sum1 = 0;
+  uint16_t sum2 = 0;
+  for (size_t i = 0; i < length; i++) {
+    sum1 = (sum1 + data[i]) % 255;
+    sum2 = (sum2 + sum1) % 255;
+  }
+  return (sum2 << 8) | sum1;
+}
+
+// states in which the string/number buffer is in use
+static bool isTokenState(uint8_t state) {
+  return state >= STATE_IN_STRING || state == STATE_START_ESCAPE || state == STATE_UNICODE
+      || state == STATE_UNICODE_SURROGATE;
+}
+
+size_t JsonStreamingParserBase::getStateSize() const {
+  size_t size = JSON_PARSER_STATE_HEADER_SIZE + stackPos + bufferPos + JSON_PARSER_STATE_CHECKSUM_SIZE;
+  for (int i = 0; i < path.count; i++) {
+    size += 4;
+    if (path.selectors[i].index < 0) {
+      size += 1 + strlen(path.selectors[i].key);
+    }
+  }
+  return size;
+}
+
+size_t JsonStreamingParserBase::getMaxStateSize() const {
+  // a key takes its length byte where the arena has its NUL
+  return JSON_PARSER_STATE_HEADER_SIZE + stackSize + path.capacity * 4 + path.keyStorageSize
+      + getMaxBufferSize() + JSON_PARSER_STATE_CHECKSUM_SIZE;
+}
+
+size_t JsonStreamingParserBase::saveState(uint8_t* blob, size_t capacity) const {
+  if (errorCode != JSON_ERROR_NONE || blob == nullptr || capacity < getStateSize()) {
+    return 0;
+  }
+
+  uint8_t* p = putState16(blob, JSON_PARSER_STATE_MAGIC);
+  *p++ = JSON_PARSER_STATE_VERSION;
+  *p++ = state;
+  *p++ = stackPos;
+  *p++ = path.count;
+  *p++ = unicodeDigits;
+  p = putState16(p, bufferPos);
+  p = putState16(p, unicodeValue);
+  p = putState32(p, characterCounter);
+  p = putState16(p, skipDepth);
+  *p++ = (skipInString ? 1 : 0) | (skipEscape ? 2 : 0);
+
+  memcpy(p, stack, stackPos);
+  p += stackPos;
+
+  for (int i = 0; i < path.count; i++) {
+    const ElementSelector& selector = path.selectors[i];
+    p = putState32(p, (uint32_t) selector.index);
+    if (selector.index < 0) {
+      uint8_t length = strlen(selector.key);
+      *p++ = length;
+      memcpy(p, selector.key, length);
+      p += length;
+    }
+  }
+
+  if (bufferPos > 0) {
+    memcpy(p, buffer, bufferPos);
+    p += bufferPos;
+  }
+
+  p = putState16(p, stateChecksum(blob, p - blob));
+  return p - blob;
+}
+
+bool JsonStreamingParserBase::restoreState(const uint8_t* blob, size_t length) {
+  if (blob == nullptr || length < JSON_PARSER_STATE_HEADER_SIZE + JSON_PARSER_STATE_CHECKSUM_SIZE
+      || getState16(blob) != JSON_PARSER_STATE_MAGIC || blob[2] != JSON_PARSER_STATE_VERSION) {
+    return false;
+  }
+  size_t dataLength = length - JSON_PARSER_STATE_CHECKSUM_SIZE;
+  if (getState16(blob + dataLength) != stateChecksum(blob, dataLength)) {
+    return false;
+  }
+
+  uint8_t savedState = blob[3];
+  uint8_t savedStackPos = blob[4];
+  uint8_t savedPathCount = blob[5];
+  uint16_t savedBufferPos = getState16(blob + 7);
+  if (savedState >= JSON_PARSER_STATE_COUNT || savedStackPos >= stackSize || savedPathCount > path.capacity
+      || (savedBufferPos > 0 && savedBufferPos >= getMaxBufferSize())) {
+    return false;
+  }
+
+  // walk the path once to validate it before touching anything
+  const uint8_t* stackData = blob + JSON_PARSER_STATE_HEADER_SIZE;
+  const uint8_t* pathData = stackData + savedStackPos;
+  const uint8_t* p = pathData;
+  const uint8_t* end = blob + dataLength;
+  size_t keyStorage = 0;
+  for (int i = 0; i < savedPathCount; i++) {
+    if (p + 4 > end) {
+      return false;
+    }
+    int32_t index = (int32_t) getState32(p);
+    p += 4;
+    keyStorage++;
+    if (index < 0) {
+      if (p >= end || p + 1 + *p > end) {
+        return false;
+      }
+      keyStorage += *p;
+      p += 1 + *p;
+    }
+  }
+  if (keyStorage > path.keyStorageSize) {
+    return false;
+  }
+  if (p + savedBufferPos != end) {
+    return false;
+  }
+
+  if (isTokenState(savedState)) {
+    if (scratchPool != nullptr && buffer == nullptr) {
+      buffer = scratchPool->acquire();
+      if (buffer == nullptr) {
+        return false;
+      }
+      bufferSize = scratchPool->getBufferSize();
+    }
+  } else {
+    releaseScratch();
+  }
+
+  state = (JsonParserState) savedState;
+
+  stackPos = savedStackPos;
+  memcpy(stack, stackData, stackPos);
+
+  path.reset();
+  p = pathData;
+  for (int i = 0; i < savedPathCount; i++) {
+    int32_t index = (int32_t) getState32(p);
+    p += 4;
+    path.push();
+    if (index < 0) {
+      uint8_t keyLength = *p++;
+      path.setKey((const char*) p, keyLength);
+      p += keyLength;
+    } else {
+      path.current->index = index;
+    }
+  }
+
+  bufferPos = savedBufferPos;
+  if (bufferPos > 0) {
+    memcpy(buffer, p, bufferPos);
+  }
+  unicodeDigits = blob[6];
+  unicodeValue = getState16(blob + 9);
+  characterCounter = getState32(blob + 11);
+  skipDepth = getState16(blob + 15);
+  skipInString = (blob[17] & 1) != 0;
+  skipEscape = (blob[17] & 2) != 0;
+  skipRequested = false;
+  sourceOrigin = 0;
+  stringSource = nullptr;
+  activeBatch = nullptr;
+  errorCode = JSON_ERROR_NONE;
+  errorMessage = nullptr;
+  if (budget != nullptr) {
+    // usage before the checkpoint is not part of the blob
+    budget->start(characterCounter);
+  }
+  return true;
+}
@@ -3,27 +3,76 @@
 
 #include <Arduino.h>
 #include "JsonHandler.h"
+#include "JsonScratchPool.h"
+#include "JsonNumberBatch.h"
+#include "JsonParserStats.h"
+#include "JsonParserBudget.h"
+
+/*
+  Parser states. Literals are matched one state per letter; the states
+  from STATE_IN_STRING on collect their bytes in the buffer. After a
+  comma (STATE_ARRAY_NEXT, STATE_OBJECT_NEXT) a value or key is required,
+  unlike after the opening bracket.
+*/
+enum JsonParserState : uint8_t {
+  STATE_START_DOCUMENT         = 0,
+  STATE_IN_ARRAY               = 1,
+  STATE_IN_OBJECT              = 2,
+  STATE_END_KEY                = 3,
+  STATE_AFTER_KEY              = 4,
+  STATE_AFTER_VALUE            = 5,
+  STATE_ARRAY_NEXT             = 6,
+  STATE_OBJECT_NEXT            = 7,
+  STATE_START_ESCAPE           = 8,
+  STATE_UNICODE                = 9,
+  STATE_UNICODE_SURROGATE      = 10,
+  STATE_IN_TRUE                = 11,
+  STATE_IN_TRUE_TR             = 12,
+  STATE_IN_TRUE_TRU            = 13,
+  STATE_IN_FALSE               = 14,
+  STATE_IN_FALSE_FA            = 15,
+  STATE_IN_FALSE_FAL           = 16,
+  STATE_IN_FALSE_FALS          = 17,
+  STATE_IN_NULL                = 18,
+  STATE_IN_NULL_NU             = 19,
+  STATE_IN_NULL_NUL            = 20,
+  STATE_IN_STRING              = 21,
+  STATE_IN_NUMBER              = 22,
+  STATE_NUMBER_FRACTION        = 23,
+  STATE_NUMBER_EXPONENT_START  = 24,
+  STATE_NUMBER_EXPONENT        = 25,
+  STATE_NUMBER_MINUS           = 26,
+  STATE_NUMBER_ZERO            = 27,
+  STATE_NUMBER_FRACTION_START  = 28,
+  STATE_NUMBER_EXPONENT_SIGN   = 29,
+  STATE_DONE                   = 0xFF
+};
+
+#define JSON_PARSER_STATE_COUNT  30
+
+/*
+  Kind of error, see getErrorCode(). The budget errors come from the
+  limits of setBudget().
+*/
+enum JsonParserError : uint8_t {
+  JSON_ERROR_NONE          = 0,
+  // malformed JSON
+  JSON_ERROR_SYNTAX        = 1,
+  // buffer, stack, path or scratch pool too small
+  JSON_ERROR_CAPACITY      = 2,
+  JSON_ERROR_BUDGET_BYTES  = 3,
+  JSON_ERROR_BUDGET_EVENTS = 4,
+  JSON_ERROR_BUDGET_DEPTH  = 5,
+  JSON_ERROR_BUDGET_STRING = 6,
+  JSON_ERROR_BUDGET_TIME   = 7
+};
 
-#define STATE_START_DOCUMENT     0
-#define STATE_DONE               -1
-#define STATE_IN_ARRAY           1
-#define STATE_IN_OBJECT          2
-#define STATE_END_KEY            3
-#define STATE_AFTER_KEY          4
-#define STATE_IN_STRING          5
-#define STATE_START_ESCAPE       6
-#define STATE_UNICODE            7
-#define STATE_IN_NUMBER          8
-#define STATE_IN_TRUE            9
-#define STATE_IN_FALSE           10
-#define STATE_IN_NULL            11
-#define STATE_AFTER_VALUE        12
-#define STATE_UNICODE_SURROGATE  13
-
-#define STACK_OBJECT             0
-#define STACK_ARRAY              1
-#define STACK_KEY                2
-#define STACK_STRING             3
+enum JsonStackEntry : uint8_t {
+  STACK_OBJECT             = 0,
+  STACK_ARRAY              = 1,
+  STACK_KEY                = 2,
+  STACK_STRING             = 3
+};
 
 #ifndef JSON_PARSER_BUFFER_MAX_LENGTH
 #define JSON_PARSER_BUFFER_MAX_LENGTH  256
@@ -37,56 +86,118 @@
 #define JSON_PARSER_PATH_MAX_DEPTH     20
 #endif
 
-class JsonStreamingParser {
+#ifndef JSON_PARSER_KEY_MAX_LENGTH
+#define JSON_PARSER_KEY_MAX_LENGTH     20
+#endif
+
+// Parser state blob layout (see JsonStreamingParserBase::saveState)
+#define JSON_PARSER_STATE_MAGIC        0x4A53
+#define JSON_PARSER_STATE_VERSION      4
+#define JSON_PARSER_STATE_HEADER_SIZE  18
+#define JSON_PARSER_STATE_CHECKSUM_SIZE 2
+
+/*
+  Parser logic, working on caller-provided storage so that every instance
+  can be sized for its workload. Most code uses JsonStreamingParser (sized
+  by the JSON_PARSER_* macros) or StaticJsonStreamingParser<...> (sized by
+  template arguments) instead of this class directly.
+
+  Members are laid out by decreasing size and use the smallest types that
+  fit (buffers up to 64 KB, stacks up to 255 levels), since servers may
+  keep thousands of parser instances alive.
+*/
+class JsonStreamingParserBase {
   private:
 
-    int state;
-    int stack[JSON_PARSER_STACK_MAX_DEPTH];
-    int stackPos = 0;
-    
-    ElementValue elementValue;
     ElementPath path;
     
-    JsonHandler* myHandler;
+    JsonHandler* myHandler = nullptr;
 
-    boolean doEmitWhitespace = false;
-	
     // fixed length buffer array to prepare for c code
-    char buffer[JSON_PARSER_BUFFER_MAX_LENGTH];
-    int bufferPos = 0;
-
-    char unicodeEscapeBuffer[10];
-    int unicodeEscapeBufferPos = 0;
-
-    char unicodeBuffer[10];
-    int unicodeBufferPos = 0;
+    char* buffer;
+    JsonStackEntry* stack;
+    JsonScratchPool* scratchPool = nullptr;
 
-    int characterCounter = 0;
+    // registered number batches, and the one of the current array
+    JsonNumberBatch* numberBatches = nullptr;
+    JsonNumberBatch* activeBatch = nullptr;
 
-    int unicodeHighSurrogate = 0;
+    JsonParserBudget* budget = nullptr;
 
     // Error handling
-    bool hasError = false;
     const char* errorMessage = nullptr;
 
+    // address of byte 0 of the document in the source of the bulk input
+    // (0 if unknown), and where the open string's text starts there
+    uintptr_t sourceOrigin = 0;
+    const char* stringSource = nullptr;
+
+    ElementValue elementValue;
+
+    uint32_t characterCounter = 0;
+
+    uint16_t bufferSize;
+    uint16_t bufferPos = 0;
+
+    // \uXXXX escape being decoded: hex digits are accumulated right away,
+    // so no scratch buffer is needed
+    uint16_t unicodeValue = 0;
+    // nesting left in the object or array being skipped (skipCurrent)
+    uint16_t skipDepth = 0;
+    uint8_t unicodeDigits = 0;
+
+    JsonParserState state;
+    uint8_t stackSize;
+    uint8_t stackPos = 0;
+    // stackPos inside the array activeBatch collects
+    uint8_t batchDepth = 0;
+
+    bool doEmitWhitespace = false;
+    JsonParserError errorCode = JSON_ERROR_NONE;
+    bool documentEnded = false;
+    bool validateOnly = false;
+    bool skipRequested = false;
+    bool skipInString = false;
+    bool skipEscape = false;
+
+#ifdef JSON_PARSER_STATS
+    JsonParserStats stats;
+#endif
+
+    void consume(char c);
+
+    size_t parseRun(const char* data, size_t length, const char* source);
+
+    size_t budgetSlice(size_t length);
+
+    bool spendEvent();
+
+    int tokenLimit() const;
+
+    void parseChar(char c);
+
+    void skipChar(char c);
+
+    void runAction(uint8_t action, char c);
+
+    void setError(const char* message, JsonParserError code = JSON_ERROR_SYNTAX);
+
+    bool acquireScratch();
+
+    void releaseScratch();
+
     void increaseBufferPointer();
 
     void endString();
 
     void endArray();
 
-    void startValue(char c);
-
     void startKey();
 
     void processEscapeCharacters(char c);
 
-    boolean isDigit(char c);
-
     boolean isHexCharacter(char c);
 
-    char convertCodepointToCharacter(int num);
-
     void endUnicodeCharacter(int codepoint);
 
     void startNumber(char c);
@@ -105,36 +216,218 @@ class JsonStreamingParser {
 
     void endDocument();
 
-    int convertDecimalBufferToInt(char myArray[], int length);
-
     void endNumber();
 
-    void endUnicodeSurrogateInterstitial();
+    bool addToBatch();
 
-    boolean doesCharArrayContain(char myArray[], int length, char c);
+    void deliverBatch();
 
-    int getHexArrayAsDecimal(char hexArray[], int length);
+    void endUnicodeSurrogateInterstitial();
 
     void processUnicodeCharacter(char c);
 
     void endObject();
 
   public:
-    JsonStreamingParser();
+    /*
+      Builds a parser over caller-provided storage:
+        buffer     bufferSize chars, holding the string/number being parsed
+                   (may be nullptr/0 if a scratch pool is attached);
+        stack      stackSize entries, one per nesting level;
+        selectors  pathDepth selectors tracking the element path;
+        keys       pathDepth * keyLength chars for the path's object keys,
+                   shared by all levels: keyLength is their average length.
+    */
+    JsonStreamingParserBase(char* buffer, int bufferSize, JsonStackEntry* stack, int stackSize,
+                            ElementSelector* selectors, int pathDepth, char* keys, int keyLength);
     void parse(char c);
+
+    /*
+      Bulk input: parses length bytes, stopping at the first error or right
+      after the end of the document. Returns the number of bytes consumed.
+    */
+    size_t parse(const char* data, size_t length);
+
+    /*
+      Bulk input copied from source, e.g. a RAM window over flash (see
+      JsonFlashReader). Consecutive calls continuing the same source let
+      strings without escapes be delivered with their source address as
+      well (ElementValue::getStringSource()).
+    */
+    size_t parse(const char* data, size_t length, const char* source);
+
+    /*
+      Validation only: checks the syntax (number grammar and escapes
+      included) and the buffer, stack and path depth limits, without
+      events, path keys or values, so no handler is needed. Runs of plain
+      string bytes are counted rather than copied.
+    */
+    void setValidateOnly(bool validateOnly) { this->validateOnly = validateOnly; }
+    bool isValidateOnly() const { return validateOnly; }
+
+    /*
+      Checks that data is one JSON document followed by whitespace only,
+      as setValidateOnly() does. Resets the parser; on failure
+      getErrorOffset() tells where data went wrong.
+    */
+    bool validate(const char* data, size_t length);
+
+    /*
+      True if the last byte parsed ended the document.
+    */
+    bool isDocumentComplete() const { return documentEnded; }
+
     void setHandler(JsonHandler* handler);
+
+    /*
+      Passes the whitespace between tokens to the handler's whitespace(),
+      e.g. to keep a document's layout when re-emitting it. Off by
+      default; never in validation mode or skipped subtrees.
+    */
+    void setEmitWhitespace(bool emit) { doEmitWhitespace = emit; }
+
+    /*
+      Limits each document to the bytes, events, depth, string length and
+      time of budget (see JsonParserBudget), nullptr for none. The budget
+      must outlive the parser; one budget may serve several parsers that
+      do not parse at the same time.
+    */
+    void setBudget(JsonParserBudget* budget);
+
+    /*
+      From the handler's startObject() or startArray(): the content of
+      that object or array is only scanned for its end, without events,
+      path tracking or buffering (nor validation), and its endObject() or
+      endArray() follows. Ignored from other callbacks.
+    */
+    void skipCurrent() { skipRequested = true; }
+
+    bool isSkipping() const { return skipDepth > 0; }
     void reset();
+
+    /*
+      Borrows the string/number buffer from pool only while a string,
+      number or literal is being parsed, instead of using the parser's own
+      (which is dropped, so build such parsers with a 0 buffer size).
+      Running out of pool buffers is reported as a parse error.
+    */
+    void setScratchPool(JsonScratchPool* pool);
+
+    /*
+      Opt-in batched delivery of numeric arrays (see JsonNumberBatch);
+      arrays matching no batch are not affected. The parser only keeps a
+      pointer: the caller owns the batch, which must stay alive until it
+      is removed (or the parser is gone). reset() keeps the batches.
+    */
+    void addNumberBatch(JsonNumberBatch* batch);
+
+    /*
+      Unregisters batch, delivering the values it still holds. Does
+      nothing if it is not registered.
+    */
+    void removeNumberBatch(JsonNumberBatch* batch);
+
+    void clearNumberBatches();
+
+    /*
+      Delivers the values collected so far, e.g. before saveState():
+      pending values are not part of the state blob.
+    */
+    void flushNumberBatch() {
+      if (activeBatch != nullptr && activeBatch->count > 0) {
+        deliverBatch();
+      }
+    }
+
+    /*
+      Checkpoint/resume: saveState() serializes everything needed to carry
+      on parsing (state, stack, element path, partially parsed string or
+      number, byte offset) into a compact, checksummed blob of at most
+      getMaxStateSize() bytes, returning its length (0 if blob is too small
+      or the parser is in error). The blob holds no pointers, so it
+      survives a reboot or deep sleep, e.g. in RTC memory.
+
+      restoreState() loads it into a parser with at least the same buffer,
+      stack and path sizes (false, leaving the parser untouched, if the
+      blob is corrupt or does not fit). Parsing then continues with byte
+      getCharacterCount() of the document, e.g. requested from the server
+      with a "Range: bytes=<getCharacterCount()>-" header. The handler's
+      own state is not part of the blob and must be saved separately.
+    */
+    size_t saveState(uint8_t* blob, size_t capacity) const;
+    bool restoreState(const uint8_t* blob, size_t length);
+    size_t getStateSize() const;
+    size_t getMaxStateSize() const;
     
     // Error handling methods
-    bool hasParseError() const { return hasError; }
+    bool hasParseError() const { return errorCode != JSON_ERROR_NONE; }
     const char* getErrorMessage() const { return errorMessage; }
-    void clearError() { hasError = false; errorMessage = nullptr; }
+    JsonParserError getErrorCode() const { return errorCode; }
+    bool isBudgetExceeded() const { return errorCode >= JSON_ERROR_BUDGET_BYTES; }
+    void clearError() { errorCode = JSON_ERROR_NONE; errorMessage = nullptr; }
+    // Byte of the document at which the error was detected: parsing
+    // stops there, so it is the last byte counted
+    uint32_t getErrorOffset() const { return hasParseError() && characterCounter > 0 ? characterCounter - 1 : 0; }
     
     // Buffer status methods
     int getBufferPosition() const { return bufferPos; }
-    int getMaxBufferSize() const { return JSON_PARSER_BUFFER_MAX_LENGTH; }
+    int getMaxBufferSize() const { return scratchPool != nullptr ? scratchPool->getBufferSize() : bufferSize; }
+    int getMaxStackDepth() const { return stackSize; }
     int getStackDepth() const { return stackPos; }
-    int getCharacterCount() const { return characterCounter; }
+    // Bytes of the current document consumed so far
+    uint32_t getCharacterCount() const { return characterCounter; }
+
+#ifdef JSON_PARSER_STATS
+    // Counters accumulate across documents until resetStats()
+    const JsonParserStats& getStats() const { return stats; }
+    void resetStats() { stats.clear(); }
+#endif
+};
+
+/*
+  Parser embedding its own storage, sized by template arguments:
+
+    StaticJsonStreamingParser<64, 8, 8, 16> configParser;      // ~0.3 KB
+    StaticJsonStreamingParser<512, 32, 32, 24> feedParser;     // ~1.6 KB
+
+  Use a 0 BUFFER_SIZE together with setScratchPool() for parsers that
+  borrow their buffer from a shared pool. KEY_LENGTH is an average: the
+  PATH_DEPTH * KEY_LENGTH chars are shared by the keys of all levels, so
+  a 60 char key fits next to short ones.
+*/
+template <int BUFFER_SIZE, int STACK_DEPTH, int PATH_DEPTH, int KEY_LENGTH>
+class StaticJsonStreamingParser: public JsonStreamingParserBase {
+  private:
+    char bufferStorage[BUFFER_SIZE > 0 ? BUFFER_SIZE : 1];
+    JsonStackEntry stackStorage[STACK_DEPTH];
+    ElementSelector selectorStorage[PATH_DEPTH];
+    char keyStorage[PATH_DEPTH * KEY_LENGTH];
+
+  public:
+    StaticJsonStreamingParser()
+      : JsonStreamingParserBase(bufferStorage, BUFFER_SIZE, stackStorage, STACK_DEPTH,
+                                selectorStorage, PATH_DEPTH, keyStorage, KEY_LENGTH) { }
+};
+
+/*
+  Parser sized by the JSON_PARSER_* macros.
+*/
+class JsonStreamingParser: public StaticJsonStreamingParser<JSON_PARSER_BUFFER_MAX_LENGTH, JSON_PARSER_STACK_MAX_DEPTH,
+                                                            JSON_PARSER_PATH_MAX_DEPTH, JSON_PARSER_KEY_MAX_LENGTH> {
+};
+
+/*
+  Static footprint report, e.g. JsonParserFootprint::print(Serial) or
+  static_assert(JsonParserFootprint::PARSER <= 1024, "...").
+*/
+struct JsonParserFootprint {
+  static const size_t PARSER_BASE = sizeof(JsonStreamingParserBase);
+  static const size_t PARSER = sizeof(JsonStreamingParser);
+  static const size_t ELEMENT_PATH = sizeof(ElementPath);
+  static const size_t ELEMENT_SELECTOR = sizeof(ElementSelector);
+  static const size_t ELEMENT_VALUE = sizeof(ElementValue);
+
+  static void print(Print& out);
 };
 
 #endif // JSON_STREAMING_PARSER2_H
@@ -0,0 +1,325 @@
+#include "JsonStreamingWriter.h"
+
+JsonStreamingWriter::JsonStreamingWriter(JsonSink* sink) {
+  this->sink = sink;
+  reset();
+}
+
+void JsonStreamingWriter::reset() {
+  depth = 0;
+  afterKey = false;
+  hasElements[0] = false;
+  hasError = false;
+  errorMessage = nullptr;
+}
+
+void JsonStreamingWriter::separate() {
+  if (afterKey) {
+    afterKey = false;
+    return;
+  }
+  if (hasElements[depth]) {
+    sink->write(',');
+  }
+  hasElements[depth] = true;
+}
+
+void JsonStreamingWriter::open(char c) {
+  separate();
+  if (depth >= JSON_WRITER_STACK_MAX_DEPTH - 1) {
+    hasError = true;
+    errorMessage = "Writer stack overflow - JSON too deeply nested";
+    return;
+  }
+  sink->write(c);
+  hasElements[++depth] = false;
+}
+
+void JsonStreamingWriter::close(char c) {
+  if (depth <= 0) {
+    hasError = true;
+    errorMessage = "Writer stack underflow - unbalanced container end";
+    return;
+  }
+  sink->write(c);
+  depth--;
+  afterKey = false;
+}
+
+void JsonStreamingWriter::beginObject() {
+  open('{');
+}
+
+void JsonStreamingWriter::endObject() {
+  close('}');
+}
+
+void JsonStreamingWriter::beginArray() {
+  open('[');
+}
+
+void JsonStreamingWriter::endArray() {
+  close(']');
+}
+
+void JsonStreamingWriter::key(const char* name) {
+  separate();
+  writeEscaped(name);
+  sink->write(':');
+  afterKey = true;
+}
+
+void JsonStreamingWriter::value(const char* value) {
+  separate();
+  writeEscaped(value);
+}
+
+void JsonStreamingWriter::value(long value) {
+  char digits[JSON_WRITER_LONG_CHARS];
+  separate();
+  sink->write(digits, formatLong(value, digits));
+}
+
+void JsonStreamingWriter::value(float value) {
+  char digits[24];
+  separate();
+  sink->write(digits, formatFloat(value, floatDigits, digits));
+}
+
+void JsonStreamingWriter::value(bool value) {
+  separate();
+  if (value) {
+    sink->write("true", 4);
+  } else {
+    sink->write("false", 5);
+  }
+}
+
+void JsonStreamingWriter::nullValue() {
+  separate();
+  sink->write("null", 4);
+}
+
+void JsonStreamingWriter::rawValue(const char* json, size_t length) {
+  separate();
+  sink->write(json, length);
+}
+
+void JsonStreamingWriter::value(ElementValue value) {
+  if (value.getNumberText() != nullptr) {
+    // parsed number: copied as is, without converting it
+    rawValue(value.getNumberText(), value.getNumberLength());
+  } else if (value.isInt()) {
+    this->value(value.getInt());
+  } else if (value.isFloat()) {
+    this->value(value.getFloat());
+  } else if (value.isString()) {
+    this->value(value.getString());
+  } else if (value.isBool()) {
+    this->value(value.getBool());
+  } else {
+    nullValue();
+  }
+}
+
+void JsonStreamingWriter::writeEscaped(const char* value) {
+  static const char hexDigits[] = "0123456789abcdef";
+
+  sink->write('"');
+  if (value != nullptr) {
+    const char* run = value;
+    const char* p = value;
+    for (;; p++) {
+      unsigned char c = (unsigned char) *p;
+      if (c >= 0x20 && c != '"' && c != '\\') {
+        continue;
+      }
+      // flush the run of chars needing no escape in one go
+      if (p > run) {
+        sink->write(run, p - run);
+      }
+      if (c == '\0') {
+        break;
+      }
+      char escape[6] = { '\\', 0, 0, 0, 0, 0 };
+      int escapeLength = 2;
+      switch (c) {
+        case '"':  escape[1] = '"'; break;
+        case '\\': escape[1] = '\\'; break;
+        case '\b': escape[1] = 'b'; break;
+        case '\f': escape[1] = 'f'; break;
+        case '\n': escape[1] = 'n'; break;
+        case '\r': escape[1] = 'r'; break;
+        case '\t': escape[1] = 't'; break;
+        default:
+          escape[1] = 'u';
+          escape[2] = '0';
+          escape[3] = '0';
+          escape[4] = hexDigits[c >> 4];
+          escape[5] = hexDigits[c & 0x0f];
+          escapeLength = 6;
+      }
+      sink->write(escape, escapeLength);
+      run = p + 1;
+    }
+  }
+  sink->write('"');
+}
+
+void JsonStreamingWriter::writeKeyOf(ElementPath& path) {
+  // Object members carry their key in the current selector; array items
+  // and the root don't.
+  if (path.getCount() > 0 && path.getCurrent()->isObject()) {
+    key(path.getKey());
+  }
+}
+
+int JsonStreamingWriter::formatLong(long value, char* buffer) {
+  char digits[JSON_WRITER_LONG_CHARS];
+  int count = 0;
+  int length = 0;
+  unsigned long magnitude = (unsigned long) value;
+  if (value < 0) {
+    buffer[length++] = '-';
+    magnitude = 0UL - magnitude;
+  }
+  do {
+    digits[count++] = (char) ('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude > 0);
+  while (count > 0) {
+    buffer[length++] = digits[--count];
+  }
+  return length;
+}
+
+int JsonStreamingWriter::formatFloat(float value, int digits, char* buffer) {
+  static const uint32_t powersOf10[] = {
+    1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+  };
+
+  // JSON has no representation for NaN and infinities
+  if (value != value || value > 3.4e38f || value < -3.4e38f) {
+    memcpy(buffer, "null", 4);
+    return 4;
+  }
+
+  int length = 0;
+  if (value < 0) {
+    buffer[length++] = '-';
+    value = -value;
+  }
+  if (value == 0) {
+    buffer[length++] = '0';
+    return length;
+  }
+  if (digits < 1) {
+    digits = 1;
+  } else if (digits > 9) {
+    digits = 9;
+  }
+
+  int exponent = 0;
+  if (value >= 1e9f || value < 1e-4f) {
+    // rare path: normalize in double so that the repeated scaling doesn't
+    // eat into the float's significant digits
+    double mantissa = value;
+    while (mantissa >= 10.0) {
+      mantissa /= 10.0;
+      exponent++;
+    }
+    while (mantissa < 1.0) {
+      mantissa *= 10.0;
+      exponent--;
+    }
+    value = (float) mantissa;
+  }
+
+  uint32_t integral = (uint32_t) value;
+  int integralDigits = 1;
+  while (integralDigits < 10 && integral >= powersOf10[integralDigits]) {
+    integralDigits++;
+  }
+  int decimals = digits - integralDigits;
+  if (integral == 0) {
+    // leading fractional zeros are not significant
+    float scaled = value;
+    while (scaled < 0.1f && decimals < 9) {
+      scaled *= 10.0f;
+      decimals++;
+    }
+  }
+  if (decimals < 0) {
+    decimals = 0;
+  } else if (decimals > 9) {
+    decimals = 9;
+  }
+
+  uint32_t scale = powersOf10[decimals];
+  uint32_t fraction = (uint32_t) ((value - (float) integral) * (float) scale + 0.5f);
+  if (fraction >= scale) {
+    integral++;
+    fraction -= scale;
+  }
+  if (exponent != 0 && integral >= 10) {
+    // rounding carried the mantissa over to the next power of ten
+    integral = 1;
+    exponent++;
+  }
+
+  length += formatLong((long) integral, buffer + length);
+
+  if (fraction > 0) {
+    // trailing zeros are dropped
+    while (fraction % 10 == 0) {
+      fraction /= 10;
+      decimals--;
+    }
+    buffer[length++] = '.';
+    for (int i = decimals - 1; i >= 0; i--) {
+      buffer[length + i] = (char) ('0' + fraction % 10);
+      fraction /= 10;
+    }
+    length += decimals;
+  }
+
+  if (exponent != 0) {
+    buffer[length++] = 'e';
+    length += formatLong(exponent, buffer + length);
+  }
+  return length;
+}
+
+void JsonStreamingWriter::startDocument() {
+  reset();
+}
+
+void JsonStreamingWriter::endDocument() {
+  sink->flush();
+}
+
+void JsonStreamingWriter::startObject(ElementPath path) {
+  writeKeyOf(path);
+  beginObject();
+}
+
+void JsonStreamingWriter::endObject(ElementPath /* path */) {
+  endObject();
+}
+
+void JsonStreamingWriter::startArray(ElementPath path) {
+  writeKeyOf(path);
+  beginArray();
+}
+
+void JsonStreamingWriter::endArray(ElementPath /* path */) {
+  endArray();
+}
+
+void JsonStreamingWriter::value(ElementPath path, ElementValue value) {
+  writeKeyOf(path);
+  this->value(value);
+}
+
+void JsonStreamingWriter::whitespace(char /* c */) {
+}
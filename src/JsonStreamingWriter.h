@@ -0,0 +1,130 @@
+#ifndef JSON_STREAMING_WRITER_H
+#define JSON_STREAMING_WRITER_H
+
+#include <Arduino.h>
+#include "JsonHandler.h"
+#include "JsonSink.h"
+
+// Chars formatLong() may write: sign and 20 digits of a 64-bit long
+#define JSON_WRITER_LONG_CHARS  24
+
+#ifndef JSON_WRITER_STACK_MAX_DEPTH
+#define JSON_WRITER_STACK_MAX_DEPTH    20
+#endif
+
+/*
+  Streaming JSON serializer.
+  It can be used standalone to build documents (beginObject(), key(),
+  value(), ...) or, being a JsonHandler itself, attached to a parser (or to
+  a filtering handler forwarding to it) to re-emit a document on the fly.
+  Output goes to a JsonSink, so no memory is ever allocated.
+*/
+class JsonStreamingWriter: public JsonHandler {
+  private:
+    JsonSink* sink;
+
+    // whether the container at each level already holds an element
+    bool hasElements[JSON_WRITER_STACK_MAX_DEPTH];
+    int depth = 0;
+    bool afterKey = false;
+
+    int floatDigits = 7;
+
+    bool hasError = false;
+    const char* errorMessage = nullptr;
+
+    void separate();
+
+    void open(char c);
+
+    void close(char c);
+
+    void writeKeyOf(ElementPath& path);
+
+    void writeEscaped(const char* value);
+
+  public:
+    JsonStreamingWriter(JsonSink* sink);
+
+    /*
+      Significant digits used when formatting floats (default: 7, which is
+      what a float can actually hold).
+    */
+    void setFloatDigits(int digits) { floatDigits = digits; }
+
+    void reset();
+
+    // Builder API
+
+    void beginObject();
+
+    void endObject();
+
+    void beginArray();
+
+    void endArray();
+
+    void key(const char* name);
+
+    void value(const char* value);
+
+    void value(long value);
+
+    void value(int value) { this->value((long) value); }
+
+    void value(float value);
+
+    /*
+      Written at float precision (setFloatDigits, at most 9 digits): the
+      value is narrowed to float first. Use rawValue() for doubles that
+      need more digits.
+    */
+    void value(double value) { this->value((float) value); }
+
+    void value(bool value);
+
+    void value(ElementValue value);
+
+    void nullValue();
+
+    /*
+      Writes an already serialized JSON fragment as the next value.
+    */
+    void rawValue(const char* json, size_t length);
+
+    bool flush() { return sink->flush(); }
+
+    bool hasWriteError() const { return hasError || sink->hasOverflowed(); }
+
+    const char* getErrorMessage() const { return hasError ? errorMessage : (sink->hasOverflowed() ? "Output overflow" : nullptr); }
+
+    int getDepth() const { return depth; }
+
+    // Fast number formatting; both return the number of chars written
+    // (no NUL terminator). buffer must hold at least
+    // JSON_WRITER_LONG_CHARS chars for longs and 24 for floats.
+
+    static int formatLong(long value, char* buffer);
+
+    static int formatFloat(float value, int digits, char* buffer);
+
+    // JsonHandler implementation
+
+    virtual void startDocument();
+
+    virtual void endDocument();
+
+    virtual void startObject(ElementPath path);
+
+    virtual void endObject(ElementPath path);
+
+    virtual void startArray(ElementPath path);
+
+    virtual void endArray(ElementPath path);
+
+    virtual void value(ElementPath path, ElementValue value);
+
+    virtual void whitespace(char c);
+};
+
+#endif // JSON_STREAMING_WRITER_H
@@ -0,0 +1,61 @@
+#include "MsgPackStreamingParser.h"
+
+void MsgPackStreamingParserBase::decodeHead(uint8_t head) {
+    if (head < 0x80) {
+      // positive fixint
+      item(BINARY_UINT, 0, head);
+    } else if (head < 0x90) {
+      item(BINARY_MAP, 0, head & 0x0F);
+    } else if (head < 0xA0) {
+      item(BINARY_ARRAY, 0, head & 0x0F);
+    } else if (head < 0xC0) {
+      item(BINARY_STRING, 0, head & 0x1F);
+    } else if (head >= 0xE0) {
+      // negative fixint, as a 32-bit immediate
+      item(BINARY_INT, 0, (uint32_t) (int32_t) (int8_t) head);
+    } else {
+      switch (head) {
+      case 0xC0:
+        item(BINARY_NULL, 0);
+        break;
+      case 0xC2:
+        item(BINARY_FALSE, 0);
+        break;
+      case 0xC3:
+        item(BINARY_TRUE, 0);
+        break;
+      case 0xC4: case 0xC5: case 0xC6:
+        // bin 8/16/32
+        item(BINARY_BYTES, 1 << (head - 0xC4));
+        break;
+      case 0xCA:
+        item(BINARY_FLOAT32, 4);
+        break;
+      case 0xCB:
+        item(BINARY_FLOAT64, 8);
+        break;
+      case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+        item(BINARY_UINT, 1 << (head - 0xCC));
+        break;
+      case 0xD0: case 0xD1: case 0xD2: case 0xD3:
+        item(BINARY_INT, 1 << (head - 0xD0));
+        break;
+      case 0xD9: case 0xDA: case 0xDB:
+        // str 8/16/32
+        item(BINARY_STRING, 1 << (head - 0xD9));
+        break;
+      case 0xDC: case 0xDD:
+        item(BINARY_ARRAY, 2 << (head - 0xDC));
+        break;
+      case 0xDE: case 0xDF:
+        item(BINARY_MAP, 2 << (head - 0xDE));
+        break;
+      case 0xC1:
+        setError("Invalid MessagePack item");
+        break;
+      default:
+        // ext 8/16/32 and fixext 1-16
+        setError("MessagePack extension types are not supported");
+      }
+    }
+}
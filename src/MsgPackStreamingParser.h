@@ -0,0 +1,52 @@
+#ifndef MSGPACK_STREAMING_PARSER_H
+#define MSGPACK_STREAMING_PARSER_H
+
+#include <Arduino.h>
+#include "BinaryStreamingParser.h"
+#include "JsonStreamingParser2.h"
+
+/*
+  Streaming MessagePack parser reporting the same JsonHandler events as
+  JsonStreamingParser, so existing handlers take MessagePack input as is.
+
+  All types but extensions are supported; 64-bit integers beyond long are
+  narrowed to float, doubles are kept for getDouble() where double is 64
+  bits wide, bin data is reported as strings. Strings must fit in the
+  buffer (including a terminating '\0').
+*/
+class MsgPackStreamingParserBase: public BinaryStreamingParserBase {
+  protected:
+    virtual void decodeHead(uint8_t head);
+
+  public:
+    MsgPackStreamingParserBase(char* buffer, int bufferSize, BinaryStackEntry* stack, int stackSize,
+                               ElementSelector* selectors, int pathDepth, char* keys, int keyLength)
+      : BinaryStreamingParserBase(buffer, bufferSize, stack, stackSize, selectors, pathDepth, keys, keyLength) { }
+};
+
+/*
+  MessagePack parser embedding its own storage, sized like
+  StaticJsonStreamingParser.
+*/
+template <int BUFFER_SIZE, int STACK_DEPTH, int PATH_DEPTH, int KEY_LENGTH>
+class StaticMsgPackStreamingParser: public MsgPackStreamingParserBase {
+  private:
+    char bufferStorage[BUFFER_SIZE];
+    BinaryStackEntry stackStorage[STACK_DEPTH];
+    ElementSelector selectorStorage[PATH_DEPTH];
+    char keyStorage[PATH_DEPTH * KEY_LENGTH];
+
+  public:
+    StaticMsgPackStreamingParser()
+      : MsgPackStreamingParserBase(bufferStorage, BUFFER_SIZE, stackStorage, STACK_DEPTH,
+                                   selectorStorage, PATH_DEPTH, keyStorage, KEY_LENGTH) { }
+};
+
+/*
+  MessagePack parser sized by the JSON_PARSER_* macros.
+*/
+class MsgPackStreamingParser: public StaticMsgPackStreamingParser<JSON_PARSER_BUFFER_MAX_LENGTH, JSON_PARSER_STACK_MAX_DEPTH,
+                                                                  JSON_PARSER_PATH_MAX_DEPTH, JSON_PARSER_KEY_MAX_LENGTH> {
+};
+
+#endif // MSGPACK_STREAMING_PARSER_H